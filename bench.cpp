@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2026 WangBin <wbsecg1 at gmail.com>
+ * MIT License
+ * https://github.com/wang-bin/lockless
+ */
+// throughput of every structure over producer/consumer count and payload size, output is csv(default) or json
+// bench [--json] [--threads max_threads] [--ops ops_per_producer]
+
+#include "spsc_fifo.h"
+#include "spsc_bounded_fifo.h"
+#include "mpsc_fifo.h"
+#include "mpmc_fifo.h"
+#include "mpmc_bounded_fifo.h"
+#include "sharded_fifo.h"
+#include "mpsc_lifo.h"
+#include "mpmc_lifo.h"
+#include "mpmc_tagged_lifo.h"
+#include "ring.h"
+#include "mpsc_ring.h"
+#include "pool.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace chrono;
+
+template<int Size>
+struct payload {
+    char data[Size];
+};
+
+struct result {
+    string name;
+    int payload;
+    int producers;
+    int consumers;
+    long long pushed;
+    long long popped;
+    long long failed_pops;
+    double seconds;
+    double efficiency; // ops/s / (ops/s of 1 producer 1 consumer * max(producers, consumers))
+
+    double ops() const { return popped/seconds; }
+};
+
+static int max_threads = (int)std::max(2u, thread::hardware_concurrency());
+static long long ops = 1 << 18; // per producer
+static bool json = false;
+
+// limits: 1 is single producer(consumer), 0 is unlimited, -1 is not thread safe(push and pop in 1 thread)
+// lossy: overwrites when full, so popped can be less than pushed. consumers of all queues stop when producers finished and queue is empty
+template<typename T> struct spsc_fifo_q { enum { producers = 1, consumers = 1, lossy = 0 };
+    spsc_fifo<T> q; bool push(const T& v) { q.push(v); return true; } bool pop(T* v) { return q.pop(v); }
+};
+template<typename T> struct spsc_bounded_fifo_q { enum { producers = 1, consumers = 1, lossy = 0 };
+    spsc_bounded_fifo<T> q{1024}; bool push(const T& v) { return q.try_push(v); } bool pop(T* v) { return q.try_pop(v); }
+};
+template<typename T> struct mpsc_fifo_q { enum { producers = 0, consumers = 1, lossy = 0 };
+    mpsc_fifo<T> q; bool push(const T& v) { q.push(v); return true; } bool pop(T* v) { return q.pop(v); }
+};
+template<typename T> struct mpmc_fifo_q { enum { producers = 0, consumers = 0, lossy = 0 };
+    mpmc_fifo<T> q; bool push(const T& v) { q.push(v); return true; } bool pop(T* v) { return q.pop(v); }
+};
+template<typename T> struct sharded_fifo_q { enum { producers = 0, consumers = 0, lossy = 0 };
+    lockless::sharded_fifo<T> q; bool push(const T& v) { q.push(v); return true; } bool pop(T* v) { return q.pop(v); }
+};
+template<typename T> struct mpmc_bounded_fifo_q { enum { producers = 0, consumers = 0, lossy = 0 };
+    mpmc_bounded_fifo<T> q{1024}; bool push(const T& v) { return q.try_push(v); } bool pop(T* v) { return q.try_pop(v); }
+};
+template<typename T> struct mpsc_lifo_q { enum { producers = 0, consumers = 1, lossy = 0 };
+    mpsc_lifo<T> q; bool push(const T& v) { q.push(v); return true; } bool pop(T* v) { return q.pop(v); }
+};
+template<typename T> struct mpmc_lifo_q { enum { producers = 0, consumers = 0, lossy = 0 };
+    mpmc_lifo<T> q; bool push(const T& v) { q.push(v); return true; } bool pop(T* v) { return q.pop(v); }
+};
+template<typename T> struct mpmc_tagged_lifo_q { enum { producers = 0, consumers = 0, lossy = 0 };
+    mpmc_tagged_lifo<T> q; bool push(const T& v) { q.push(v); return true; } bool pop(T* v) { return q.pop(v); }
+};
+template<typename T> struct ring_q { enum { producers = -1, consumers = -1, lossy = 1 };
+    ring<T> q{1024}; bool push(const T& v) { q.push(v); return true; } bool pop(T* v) { return q.pop(v) > 0; }
+};
+template<typename T> struct ring_mutex_q { enum { producers = 0, consumers = 0, lossy = 1 };
+    ring<T, std::mutex> q{1024}; bool push(const T& v) { q.push(v); return true; } bool pop(T* v) { return q.pop(v) > 0; }
+};
+template<typename T> struct mpsc_ring_q { enum { producers = 0, consumers = 1, lossy = 1 };
+    lockless::mpsc::ring<T> q{1024}; bool push(const T& v) { q.push(v); return true; } bool pop(T* v) { return q.pop(v) > 0; }
+};
+template<typename T> struct mutex_deque_q { enum { producers = 0, consumers = 0, lossy = 0 }; // baseline
+    std::mutex mtx; std::deque<T> q;
+    bool push(const T& v) {
+        std::lock_guard<std::mutex> lock(mtx);
+        q.push_back(v);
+        return true;
+    }
+    bool pop(T* v) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (q.empty())
+            return false;
+        *v = q.front();
+        q.pop_front();
+        return true;
+    }
+};
+
+template<template<typename> class Q, typename T>
+result run(const char* name, int np, int nc) {
+    result r{name, (int)sizeof(T), np, nc, 0, 0, 0, 0, 0};
+    auto q = std::make_unique<Q<T>>();
+    const auto t0 = steady_clock::now();
+    if (Q<T>::producers < 0) {
+        T v{};
+        for (long long i = 0; i < ops; ++i) {
+            r.pushed += q->push(v);
+            if (q->pop(&v))
+                r.popped++;
+            else
+                r.failed_pops++;
+        }
+    } else {
+        atomic<long long> pushed{0}, popped{0}, failed{0};
+        atomic<int> producing{np};
+        vector<thread> ts;
+        for (int k = 0; k < np; ++k) {
+            ts.emplace_back([&]{
+                T v{};
+                long long n = 0;
+                for (long long i = 0; i < ops; ++i) {
+                    while (!q->push(v)) // bounded queue is full
+                        this_thread::yield();
+                    n++;
+                }
+                pushed += n;
+                producing--;
+            });
+        }
+        for (int k = 0; k < nc; ++k) {
+            ts.emplace_back([&]{
+                T v;
+                long long n = 0, f = 0;
+                for (;;) { // counts are local, a shared counter per pop would be measured too
+                    if (q->pop(&v)) {
+                        n++;
+                        continue;
+                    }
+                    f++;
+                    if (producing.load() == 0 && !q->pop(&v)) // all pushes are done, so empty
+                        break;
+                    this_thread::yield();
+                }
+                popped += n;
+                failed += f;
+            });
+        }
+        for (auto& t : ts)
+            t.join();
+        r.pushed = pushed;
+        r.popped = popped;
+        r.failed_pops = failed;
+        if (!Q<T>::lossy && r.popped != r.pushed)
+            fprintf(stderr, "%s: pushed %lld, popped %lld\n", name, r.pushed, r.popped);
+    }
+    r.seconds = duration<double>(steady_clock::now() - t0).count();
+    return r;
+}
+
+template<typename T>
+result run_pool(const char* name, int nt) {
+    result r{name, (int)sizeof(T), nt, nt, 0, 0, 0, 0, 0};
+    mpmc_pool<T> p;
+    const auto t0 = steady_clock::now();
+    vector<thread> ts;
+    for (int k = 0; k < nt; ++k) {
+        ts.emplace_back([&p]{
+            for (long long i = 0; i < ops; ++i)
+                auto v = p.get2([]{ return new T(); });
+        });
+    }
+    for (auto& t : ts)
+        t.join();
+    r.seconds = duration<double>(steady_clock::now() - t0).count();
+    r.pushed = r.popped = ops*nt;
+    return r;
+}
+
+static vector<int> thread_counts(int limit) {
+    if (limit < 0)
+        return {1};
+    vector<int> v;
+    const int n = limit == 1 ? 1 : max_threads;
+    for (int i = 1; i <= n; i *= 2)
+        v.push_back(i);
+    if (v.back() != n)
+        v.push_back(n);
+    return v;
+}
+
+static void print(const result& r, bool first) {
+    if (json) {
+        printf("%s{\"name\":\"%s\",\"payload\":%d,\"producers\":%d,\"consumers\":%d,\"pushed\":%lld,\"popped\":%lld,\"failed_pops\":%lld,\"failed_pop_ratio\":%.4f,\"seconds\":%.6f,\"ops_per_sec\":%.0f,\"efficiency\":%.3f}"
+            , first ? "  " : ",\n  ", r.name.data(), r.payload, r.producers, r.consumers, r.pushed, r.popped, r.failed_pops
+            , double(r.failed_pops)/double(r.failed_pops + r.popped + 1), r.seconds, r.ops(), r.efficiency);
+    } else {
+        printf("%s,%d,%d,%d,%lld,%lld,%lld,%.4f,%.6f,%.0f,%.3f\n"
+            , r.name.data(), r.payload, r.producers, r.consumers, r.pushed, r.popped, r.failed_pops
+            , double(r.failed_pops)/double(r.failed_pops + r.popped + 1), r.seconds, r.ops(), r.efficiency);
+    }
+    fflush(stdout);
+}
+
+static bool first_result = true;
+
+static void report(vector<result>& rs) {
+    for (auto& r : rs) {
+        r.efficiency = r.ops()/(rs[0].ops()*std::max(r.producers, r.consumers));
+        print(r, first_result);
+        first_result = false;
+    }
+}
+
+template<template<typename> class Q, typename T>
+void bench(const char* name) {
+    vector<result> rs;
+    for (int np : thread_counts(Q<T>::producers)) {
+        for (int nc : thread_counts(Q<T>::consumers))
+            rs.push_back(run<Q, T>(name, np, nc));
+    }
+    report(rs);
+}
+
+template<typename T>
+void bench_all() {
+    bench<mutex_deque_q, T>("mutex_deque");
+    bench<spsc_fifo_q, T>("spsc_fifo");
+    bench<spsc_bounded_fifo_q, T>("spsc_bounded_fifo");
+    bench<mpsc_fifo_q, T>("mpsc_fifo");
+    bench<mpmc_fifo_q, T>("mpmc_fifo");
+    bench<sharded_fifo_q, T>("sharded_fifo");
+    bench<mpmc_bounded_fifo_q, T>("mpmc_bounded_fifo");
+    bench<mpsc_lifo_q, T>("mpsc_lifo");
+    bench<mpmc_lifo_q, T>("mpmc_lifo");
+    bench<mpmc_tagged_lifo_q, T>("mpmc_tagged_lifo");
+    bench<ring_q, T>("ring");
+    bench<ring_mutex_q, T>("ring_mutex");
+    bench<mpsc_ring_q, T>("mpsc_ring");
+    vector<result> rs;
+    for (int nt : thread_counts(0))
+        rs.push_back(run_pool<T>("mpmc_pool", nt));
+    report(rs);
+}
+
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--json") == 0)
+            json = true;
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            max_threads = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--ops") == 0 && i + 1 < argc)
+            ops = std::max(1LL, atoll(argv[++i]));
+    }
+    if (json)
+        printf("[\n");
+    else
+        printf("name,payload,producers,consumers,pushed,popped,failed_pops,failed_pop_ratio,seconds,ops_per_sec,efficiency\n");
+    bench_all<payload<4>>();
+    bench_all<payload<16>>();
+    bench_all<payload<64>>();
+    bench_all<payload<256>>();
+    bench_all<payload<1024>>();
+    if (json)
+        printf("\n]\n");
+    return 0;
+}
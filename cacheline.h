@@ -0,0 +1,12 @@
+/*
+ * Copyright (c) 2026 WangBin <wbsecg1 at gmail.com>
+ * MIT License
+ * https://github.com/wang-bin/lockless
+ */
+#pragma once
+#include <cstddef>
+
+namespace lockless {
+// std::hardware_destructive_interference_size is not available everywhere, and g++ warns if it's used in headers(abi may change)
+constexpr size_t cacheline_size = 64;
+} // namespace lockless
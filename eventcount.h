@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2026 WangBin <wbsecg1 at gmail.com>
+ * MIT License
+ * Event Count
+ * https://github.com/wang-bin/lockless
+ */
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#if defined(__linux__)
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+// block a lock free consumer(or producer) until the condition may be changed, without a lock in the fast path
+// waiter: if (!try_pop()) { k = prepare_wait(); if (try_pop()) cancel_wait(); else wait(k); }, or simply await(try_pop)
+// notifier: push(); notify_one(); notify is a fence + load if nobody is waiting, syscall(linux futex) only if someone is waiting
+// queues take the wait policy as a template parameter: spin_wait(default) or eventcount. spin_wait has no cost in push/pop, await() yields instead of blocking
+namespace lockless {
+
+struct spin_wait {
+    void notify_one() {}
+    void notify_all() {}
+
+    template<typename F>
+    void await(F&& f) {
+        while (!f())
+            std::this_thread::yield();
+    }
+
+    template<typename F, class Rep, class Period>
+    bool await_for(F&& f, const std::chrono::duration<Rep, Period>& timeout) {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!f()) {
+            if (std::chrono::steady_clock::now() >= deadline)
+                return f();
+            std::this_thread::yield();
+        }
+        return true;
+    }
+};
+
+class eventcount {
+public:
+    using key = uint32_t;
+
+    key prepare_wait() {
+        waiters_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst); // waiters_ must be visible before checking the condition again. pair with the fence in notify()
+        return epoch_.load(std::memory_order_relaxed);
+    }
+
+    void cancel_wait() {
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // block until notified after prepare_wait() returns k
+    void wait(key k) {
+        while (epoch_.load(std::memory_order_acquire) == k)
+            wait_epoch(k, nullptr);
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // return false if timeout
+    bool wait_until(key k, std::chrono::steady_clock::time_point deadline) {
+        bool changed = false;
+        for (;;) {
+            changed = epoch_.load(std::memory_order_acquire) != k;
+            const auto now = std::chrono::steady_clock::now();
+            if (changed || now >= deadline)
+                break;
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now);
+            wait_epoch(k, &ns);
+        }
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+        return changed;
+    }
+
+    void notify_one() { notify(1); }
+    void notify_all() { notify(INT32_MAX); }
+
+    // block until f() returns true
+    template<typename F>
+    void await(F&& f) {
+        while (!f()) {
+            const key k = prepare_wait();
+            if (f()) {
+                cancel_wait();
+                return;
+            }
+            wait(k);
+        }
+    }
+
+    // block until f() returns true, or return false if timeout
+    template<typename F, class Rep, class Period>
+    bool await_for(F&& f, const std::chrono::duration<Rep, Period>& timeout) {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!f()) {
+            const key k = prepare_wait();
+            if (f()) {
+                cancel_wait();
+                return true;
+            }
+            if (!wait_until(k, deadline))
+                return f();
+        }
+        return true;
+    }
+private:
+    void notify(int n) {
+        std::atomic_thread_fence(std::memory_order_seq_cst); // condition must be visible before checking waiters_
+        if (waiters_.load(std::memory_order_relaxed) == 0)
+            return;
+        epoch_.fetch_add(1, std::memory_order_release);
+        wake_epoch(n);
+    }
+
+#if defined(__linux__)
+    void wait_epoch(key k, const std::chrono::nanoseconds* timeout) {
+        timespec ts;
+        if (timeout) {
+            ts.tv_sec = time_t(timeout->count()/1000000000);
+            ts.tv_nsec = long(timeout->count()%1000000000);
+        }
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAIT_PRIVATE, k, timeout ? &ts : nullptr, nullptr, 0); // EAGAIN if epoch_ != k, EINTR, ETIMEDOUT are all ok
+    }
+
+    void wake_epoch(int n) {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAKE_PRIVATE, n, nullptr, nullptr, 0);
+    }
+#else
+    void wait_epoch(key k, const std::chrono::nanoseconds* timeout) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        const auto changed = [this, k]{ return epoch_.load(std::memory_order_relaxed) != k; };
+        if (timeout)
+            cv_.wait_for(lock, *timeout, changed);
+        else
+            cv_.wait(lock, changed);
+    }
+
+    void wake_epoch(int n) {
+        { std::lock_guard<std::mutex> lock(mtx_); } // a waiter checked epoch_ is waiting in cv_ now
+        if (n == 1)
+            cv_.notify_one();
+        else
+            cv_.notify_all();
+    }
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+#endif
+    std::atomic<key> epoch_ = {0}; // futex word
+    std::atomic<uint32_t> waiters_ = {0};
+};
+} // namespace lockless
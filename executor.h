@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2026 WangBin <wbsecg1 at gmail.com>
+ * MIT License
+ * Work Stealing Thread Pool
+ * https://github.com/wang-bin/lockless
+ */
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "eventcount.h"
+#include "mpmc_fifo.h"
+#include "ws_deque.h"
+
+// submit() in a worker pushes to the worker's ws_deque, otherwise to the global mpmc_fifo. idle workers pop local, pop global, then steal others
+// workers park on an eventcount(futex) when no work is found, so a submit() costs a fence + load if no worker is parked
+namespace lockless {
+
+// a callable is stored inline if it's trivially copyable and fits sbo_size, e.g. lambdas capture by reference, otherwise it's moved to heap.
+// invoking a task consumes it. a task never invoked destroys its callable when destroyed.
+// move only. release() gives the trivially copyable raw form stored in ws_deque and mpmc_fifo, task(raw) takes it back
+class task {
+public:
+    static constexpr size_t sbo_size = 48;
+
+    struct raw {
+        alignas(std::max_align_t) unsigned char buf[sbo_size];
+        void (*op)(void* buf, bool invoke) = nullptr; // invoke(optional) then destroy the callable
+    };
+
+    task() = default;
+    explicit task(const raw& r) : raw_(r) {}
+    template<typename F, typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, task>::value && !std::is_same<typename std::decay<F>::type, raw>::value>::type>
+    task(F&& f) {
+        using Fn = typename std::decay<F>::type;
+        if constexpr (std::is_trivially_copyable<Fn>::value && sizeof(Fn) <= sbo_size && alignof(Fn) <= alignof(std::max_align_t)) {
+            new (raw_.buf) Fn(std::forward<F>(f));
+            raw_.op = [](void* buf, bool invoke) {
+                Fn* p = std::launder(reinterpret_cast<Fn*>(buf));
+                if (invoke)
+                    (*p)();
+                p->~Fn();
+            };
+        } else {
+            Fn* p = new Fn(std::forward<F>(f));
+            memcpy(raw_.buf, &p, sizeof(p));
+            raw_.op = [](void* buf, bool invoke) {
+                Fn* p;
+                memcpy(&p, buf, sizeof(p));
+                std::unique_ptr<Fn> holder(p); // deleted even if throws
+                if (invoke)
+                    (*p)();
+            };
+        }
+    }
+
+    task(task&& o) noexcept : raw_(o.release()) {}
+    task& operator=(task&& o) noexcept {
+        if (this != &o) {
+            reset();
+            raw_ = o.release();
+        }
+        return *this;
+    }
+    ~task() { reset(); }
+
+    explicit operator bool() const { return !!raw_.op; }
+
+    void operator()() {
+        raw r = release();
+        r.op(r.buf, true);
+    }
+
+    // the callable is owned by the returned value now
+    raw release() {
+        raw r = raw_;
+        raw_.op = nullptr;
+        return r;
+    }
+
+    void reset() {
+        if (!raw_.op)
+            return;
+        raw r = release();
+        r.op(r.buf, false);
+    }
+private:
+    raw raw_;
+};
+
+class executor {
+public:
+    executor(int threads = (int)std::thread::hardware_concurrency()) {
+        threads = std::max(1, threads);
+        for (int i = 0; i < threads; ++i)
+            local_.emplace_back(new ws_deque<task::raw>());
+        for (int i = 0; i < threads; ++i)
+            workers_.emplace_back([this, i]{ run(i); });
+    }
+
+    // remaining tasks are executed before destroyed
+    ~executor() {
+        stop_.store(true, std::memory_order_relaxed);
+        parked_.notify_all();
+        for (auto& t : workers_)
+            t.join();
+        task t;
+        while (find(-1, &t)) // global and local deques, so no task is leaked
+            t();
+    }
+
+    int size() const { return (int)workers_.size(); }
+
+    template<typename F>
+    void submit(F&& f) {
+        push(task(std::forward<F>(f)));
+    }
+
+    void push(task t) {
+        const int i = worker_index();
+        if (i >= 0)
+            local_[i]->push(t.release());
+        else
+            global_.push(t.release());
+        parked_.notify_one();
+    }
+
+    // run f(i) for i in [begin, end) by chunks of grain, the calling thread runs tasks too until all chunks are done
+    template<typename F>
+    void parallel_for(int begin, int end, F&& f, int grain = 0) {
+        if (begin >= end)
+            return;
+        if (grain <= 0)
+            grain = std::max(1, (end - begin)/(size()*4));
+        std::atomic<int> pending{(end - begin + grain - 1)/grain};
+        for (int b = begin; b < end; b += grain) {
+            const int e = std::min(end, b + grain);
+            submit([&f, &pending, b, e]{
+                for (int i = b; i < e; ++i)
+                    f(i);
+                pending.fetch_sub(1, std::memory_order_release);
+            });
+        }
+        task t;
+        while (pending.load(std::memory_order_acquire) > 0) {
+            if (find(worker_index(), &t))
+                t();
+            else
+                std::this_thread::yield();
+        }
+    }
+private:
+    struct current {
+        const executor* owner;
+        int index;
+    };
+    static current& this_worker() {
+        thread_local current w{nullptr, -1};
+        return w;
+    }
+    // -1 if not a worker of this executor
+    int worker_index() const {
+        const current& w = this_worker();
+        return w.owner == this ? w.index : -1;
+    }
+
+    // i: worker index, or -1
+    bool find(int i, task* t) {
+        task::raw r;
+        bool found = (i >= 0 && local_[i]->pop(&r)) || global_.pop(&r);
+        const int n = (int)local_.size();
+        for (int k = 1; !found && k <= n; ++k) {
+            const int victim = (i + k) % n;
+            found = victim != i && local_[victim]->steal(&r);
+        }
+        if (found)
+            *t = task(r);
+        return found;
+    }
+
+    // a parked worker costs submit() a syscall to wake, so try a while before parking
+    bool spin(int i, task* t) {
+        for (int k = 0; k < 64; ++k) {
+            std::this_thread::yield();
+            if (find(i, t))
+                return true;
+        }
+        return false;
+    }
+
+    void run(int i) {
+        this_worker() = current{this, i};
+        task t;
+        for (;;) {
+            if (find(i, &t)) {
+                t();
+                continue;
+            }
+            if (spin(i, &t)) {
+                t();
+                continue;
+            }
+            const eventcount::key k = parked_.prepare_wait();
+            if (find(i, &t)) {
+                parked_.cancel_wait();
+                t();
+                continue;
+            }
+            if (stop_.load(std::memory_order_relaxed)) {
+                parked_.cancel_wait();
+                break;
+            }
+            parked_.wait(k);
+        }
+    }
+
+    std::vector<std::unique_ptr<ws_deque<task::raw>>> local_;
+    mpmc_fifo<task::raw> global_;
+    eventcount parked_;
+    std::atomic<bool> stop_ = {false};
+    std::vector<std::thread> workers_;
+};
+} // namespace lockless
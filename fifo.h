@@ -4,28 +4,32 @@
  * MIT License
  * https://github.com/wang-bin/lockless
  */
+#pragma once
 #include <atomic>
+#include <memory>
 #include <utility>
 
-template<typename T>
+template<typename T, class Allocator = std::allocator<T>>
 class fifo {
 public:
+    fifo(const Allocator& a = Allocator()) : alloc_(a) { in_ = out_ = new_node(); }
+
     ~fifo() {
         clear();
-        delete out_;
+        delete_node(out_);
     }
 
     void clear() { while(pop()) {}} // in consumer thread
 
     template<typename... Args>
     void emplace(Args&&... args) {
-        node *n = new node{std::forward<Args>(args)...};
+        node *n = new_node(std::forward<Args>(args)...);
         in_->next = n;
         in_ = n;
     }
 
     void push(T&& v) {
-        node *n = new node{std::move(v)};
+        node *n = new_node(std::move(v));
         in_->next = n;
         in_ = n;
     }
@@ -37,7 +41,7 @@ public:
         out_ = h->next;
         if (v)
             *v = std::move(h->next->v);
-        delete h;
+        delete_node(h);
         return true;
     }
 private:
@@ -46,7 +50,27 @@ private:
         node *next;
     };
 
-    node *out_ = new node();
-    node* in_ = out_;
+    using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<node>;
+    using node_traits = std::allocator_traits<node_allocator>;
+
+    template<typename... Args>
+    node* new_node(Args&&... args) {
+        node* n = node_traits::allocate(alloc_, 1);
+        try {
+            return ::new (n) node{std::forward<Args>(args)...};
+        } catch (...) {
+            node_traits::deallocate(alloc_, n, 1);
+            throw;
+        }
+    }
+
+    void delete_node(node* n) {
+        n->~node();
+        node_traits::deallocate(alloc_, n, 1);
+    }
+
+    node_allocator alloc_;
+    node *out_ = nullptr;
+    node* in_ = nullptr;
 };
 
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2026 WangBin <wbsecg1 at gmail.com>
+ * MIT License
+ * Hazard Pointer Memory Reclamation
+ * https://github.com/wang-bin/lockless
+ */
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <vector>
+#include "cacheline.h"
+
+// Maged M. Michael, Hazard Pointers: Safe Memory Reclamation for Lock-Free Objects
+// every thread owns a record of hazard_domain::slots pointers. a retired pointer is deleted by scan() iff no record protects it.
+// a thread scans only when its retired list reaches threshold(), so reclamation is amortized and
+// unreclaimed memory is bounded by threads * threshold() no matter how busy consumers are
+namespace lockless {
+
+class hazard_domain {
+public:
+    static constexpr int slots = 2;
+
+    struct retired_ptr {
+        void* p;
+        void (*deleter)(void*);
+    };
+
+    struct alignas(cacheline_size) record {
+        std::atomic<const void*> hp[slots] = {};
+        std::atomic<bool> active = {false};
+        record* next = nullptr;
+        std::vector<retired_ptr> retired; // accessed by owner thread only
+        std::atomic<size_t> backlog = {0}; // retired.size() for other threads
+        unsigned owned = 0; // bit i: hp[i] is set by a live hazard_guard of owner thread
+    };
+
+    static hazard_domain& instance() {
+        static hazard_domain d;
+        return d;
+    }
+
+    ~hazard_domain() { // all threads are finished
+        record* r = head_.load();
+        while (r) {
+            for (auto& i : r->retired)
+                i.deleter(i.p);
+            record* next = r->next;
+            delete r;
+            r = next;
+        }
+    }
+
+    // record of current thread, released when thread exits
+    record* local() {
+        thread_local local_record t;
+        if (!t.rec)
+            t.rec = acquire();
+        return t.rec;
+    }
+
+    record* acquire() {
+        for (record* r = head_.load(std::memory_order_acquire); r; r = r->next) {
+            if (r->active.load(std::memory_order_relaxed))
+                continue;
+            bool expected = false;
+            if (r->active.compare_exchange_strong(expected, true, std::memory_order_acquire)) // reuse record and retired list of an exited thread
+                return r;
+        }
+        record* r = new record();
+        r->active.store(true, std::memory_order_relaxed);
+        r->next = head_.load(std::memory_order_relaxed);
+        while (!head_.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed)) {}
+        records_.fetch_add(1, std::memory_order_relaxed);
+        return r;
+    }
+
+    void release(record* r) {
+        for (auto& h : r->hp)
+            h.store(nullptr, std::memory_order_release);
+        r->owned = 0;
+        if (!r->retired.empty())
+            scan(r);
+        r->active.store(false, std::memory_order_release); // remaining retired pointers will be scanned by next owner
+    }
+
+    void retire(record* r, void* p, void (*deleter)(void*)) {
+        r->retired.push_back({p, deleter});
+        if (r->retired.size() >= threshold())
+            scan(r);
+        else
+            r->backlog.store(r->retired.size(), std::memory_order_relaxed);
+    }
+
+    // delete retired pointers of r not protected by any thread
+    void scan(record* r) {
+        std::vector<const void*> hazards;
+        hazards.reserve(slots*records_.load(std::memory_order_relaxed));
+        std::atomic_thread_fence(std::memory_order_seq_cst); // pair with the fence in hazard_guard::protect()
+        for (record* i = head_.load(std::memory_order_acquire); i; i = i->next) {
+            for (auto& h : i->hp) {
+                if (const void* p = h.load(std::memory_order_acquire))
+                    hazards.push_back(p);
+            }
+        }
+        std::sort(hazards.begin(), hazards.end());
+        auto keep = std::partition(r->retired.begin(), r->retired.end(), [&hazards](const retired_ptr& i){
+            return std::binary_search(hazards.begin(), hazards.end(), (const void*)i.p);
+        });
+        for (auto i = keep; i != r->retired.end(); ++i)
+            i->deleter(i->p);
+        r->retired.erase(keep, r->retired.end());
+        r->backlog.store(r->retired.size(), std::memory_order_relaxed);
+    }
+
+    // number of retired but not deleted pointers
+    size_t backlog() const {
+        size_t n = 0;
+        for (record* r = head_.load(std::memory_order_acquire); r; r = r->next)
+            n += r->backlog.load(std::memory_order_relaxed);
+        return n;
+    }
+
+    // number of thread records, i.e. max number of threads using hazard pointers at the same time
+    int records() const { return records_.load(std::memory_order_relaxed); }
+
+    // at least half of retired pointers can be deleted in a scan
+    size_t threshold() const {
+        return std::max<size_t>(64, 2*slots*records_.load(std::memory_order_relaxed));
+    }
+private:
+    hazard_domain() = default;
+
+    struct local_record {
+        record* rec = nullptr;
+        ~local_record() {
+            if (rec)
+                hazard_domain::instance().release(rec);
+        }
+    };
+
+    std::atomic<record*> head_ = {nullptr};
+    std::atomic<int> records_ = {0};
+};
+
+// protect pointers in current scope. guards can be nested if they use different slots, a guard clears only the slots it set
+class hazard_guard {
+public:
+    hazard_guard() : rec_(hazard_domain::instance().local()) {}
+    ~hazard_guard() { clear(); }
+    hazard_guard(const hazard_guard&) = delete;
+    hazard_guard& operator=(const hazard_guard&) = delete;
+
+    // load src until the value is protected
+    template<typename P>
+    P* protect(int i, const std::atomic<P*>& src) {
+        P* p = src.load(std::memory_order_relaxed);
+        for (;;) {
+            set(i, p);
+            P* q = src.load(std::memory_order_acquire);
+            if (q == p)
+                return p;
+            p = q;
+        }
+    }
+
+    // caller must validate p is still reachable after set()
+    void set(int i, const void* p) {
+        assert(!(rec_->owned & ~used_ & (1u << i)) && "slot is set by an outer hazard_guard");
+        used_ |= 1u << i;
+        rec_->owned |= 1u << i;
+        rec_->hp[i].store(p, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst); // store hazard pointer before validation load
+    }
+
+    void reset(int i) {
+        if (!(used_ & (1u << i)))
+            return;
+        rec_->hp[i].store(nullptr, std::memory_order_release);
+        used_ &= ~(1u << i);
+        rec_->owned &= ~(1u << i);
+    }
+
+    void clear() {
+        for (int i = 0; used_; ++i)
+            reset(i);
+    }
+
+    // p must be unreachable for other threads
+    template<typename P>
+    void retire(P* p) {
+        hazard_domain::instance().retire(rec_, p, [](void* x){ delete static_cast<P*>(x); });
+    }
+
+    // deleter is called by any thread, so it can not have a state
+    void retire(void* p, void (*deleter)(void*)) {
+        hazard_domain::instance().retire(rec_, p, deleter);
+    }
+private:
+    hazard_domain::record* rec_;
+    unsigned used_ = 0; // slots set by this guard
+};
+} // namespace lockless
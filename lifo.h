@@ -4,13 +4,14 @@
  * MIT License
  * https://github.com/wang-bin/lockless
  */
+#pragma once
 #include <atomic>
 #include <utility>
 
 template<typename T>
-class fifo {
+class lifo {
 public:
-    ~fifo() {
+    ~lifo() {
         clear();
     }
 
@@ -45,5 +46,5 @@ private:
         node *next;
     };
 
-    node *io_ = nullptr;;
+    node *io_ = nullptr;
 };
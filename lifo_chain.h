@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2026 WangBin <wbsecg1 at gmail.com>
+ * MIT License
+ * https://github.com/wang-bin/lockless
+ */
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+namespace lockless {
+
+// nodes detached from a lifo by pop_all(), newest first. Node is {T v; Node* next;}, or {T v; std::atomic<Node*> next;} if a stale pop() may still read next
+// Reclaim::release(Node* head) frees the whole chain when chain is destroyed. Reclaim can have a state, e.g. an allocator
+template<typename T, typename Node, class Reclaim>
+class lifo_chain : private Reclaim {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        explicit iterator(Node* n = nullptr) : n_(n) {}
+        T& operator*() const { return n_->v; }
+        T* operator->() const { return &n_->v; }
+        iterator& operator++() {
+            n_ = next_of(n_);
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator i = *this;
+            n_ = next_of(n_);
+            return i;
+        }
+        bool operator==(const iterator& o) const { return n_ == o.n_; }
+        bool operator!=(const iterator& o) const { return n_ != o.n_; }
+    private:
+        Node* n_;
+    };
+
+    lifo_chain() = default;
+    explicit lifo_chain(Node* head, Reclaim r = Reclaim()) : Reclaim(std::move(r)), head_(head) {}
+    lifo_chain(lifo_chain&& o) noexcept : Reclaim(std::move(o)), head_(o.head_) { o.head_ = nullptr; }
+    lifo_chain& operator=(lifo_chain&& o) noexcept {
+        if (this != &o) {
+            clear();
+            Reclaim::operator=(std::move(o));
+            head_ = o.head_;
+            o.head_ = nullptr;
+        }
+        return *this;
+    }
+    lifo_chain(const lifo_chain&) = delete;
+    lifo_chain& operator=(const lifo_chain&) = delete;
+    ~lifo_chain() { clear(); }
+
+    iterator begin() const { return iterator(head_); }
+    iterator end() const { return iterator(); }
+    bool empty() const { return !head_; }
+
+    int size() const {
+        int n = 0;
+        for (Node* i = head_; i; i = next_of(i))
+            n++;
+        return n;
+    }
+
+    // oldest first, i.e. fifo order
+    void reverse() {
+        Node* r = nullptr;
+        while (head_) {
+            Node* next = next_of(head_);
+            set_next(head_, r);
+            r = head_;
+            head_ = next;
+        }
+        head_ = r;
+    }
+
+    void clear() {
+        if (head_)
+            this->release(head_);
+        head_ = nullptr;
+    }
+private:
+    static Node* next_of(const Node* n) { return load(n->next); }
+    static void set_next(Node* n, Node* next) { store(n->next, next); }
+    static Node* load(Node* const& p) { return p; }
+    static Node* load(const std::atomic<Node*>& p) { return p.load(std::memory_order_relaxed); }
+    static void store(Node*& p, Node* v) { p = v; }
+    static void store(std::atomic<Node*>& p, Node* v) { p.store(v, std::memory_order_relaxed); }
+
+    Node* head_ = nullptr;
+};
+} // namespace lockless
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2026 WangBin <wbsecg1 at gmail.com>
+ * MIT License
+ * Wait Free SPSC Mirrored Byte Ring
+ * https://github.com/wang-bin/lockless
+ */
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <system_error>
+#include <sys/mman.h>
+#include <unistd.h>
+#if !defined(__linux__)
+#include <cstdio>
+#include <fcntl.h>
+#endif
+#include "cacheline.h"
+
+// the same pages are mapped twice back to back, so any window of at most capacity() bytes starting anywhere in the ring is contiguous.
+// producer writes at write_ptr() and commit(n), consumer reads at read_ptr() and consume(n), no copy and no wrap-around handling.
+// in_ and out_ are positions increased forever, producer only writes in_, consumer only writes out_. posix only
+namespace lockless {
+
+class mirror_ring {
+public:
+    // capacity is rounded up to page size
+    mirror_ring(size_t cap) {
+        const size_t page = size_t(sysconf(_SC_PAGESIZE));
+        cap_ = (cap + page - 1)/page*page;
+        if (cap_ == 0)
+            cap_ = page;
+#if defined(__linux__)
+        const int fd = memfd_create("lockless.mirror_ring", MFD_CLOEXEC);
+#else
+        char name[64];
+        snprintf(name, sizeof(name), "/lockless.mirror_ring.%d.%p", (int)getpid(), (void*)this);
+        const int fd = shm_open(name, O_RDWR|O_CREAT|O_EXCL, 0600);
+        if (fd >= 0)
+            shm_unlink(name);
+#endif
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), "mirror_ring create memory file");
+        if (ftruncate(fd, off_t(cap_)) != 0)
+            fail(fd, "mirror_ring ftruncate");
+        // reserve 2x address space, then map the file to each half
+        void* p = mmap(nullptr, 2*cap_, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            fail(fd, "mirror_ring reserve");
+        data_ = static_cast<uint8_t*>(p);
+        if (mmap(data_, cap_, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, fd, 0) == MAP_FAILED
+            || mmap(data_ + cap_, cap_, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, fd, 0) == MAP_FAILED) {
+            const int e = errno;
+            munmap(data_, 2*cap_);
+            errno = e;
+            fail(fd, "mirror_ring map");
+        }
+        close(fd); // mappings keep the file
+    }
+
+    ~mirror_ring() {
+        munmap(data_, 2*cap_);
+    }
+
+    mirror_ring(const mirror_ring&) = delete;
+    mirror_ring& operator=(const mirror_ring&) = delete;
+
+    size_t capacity() const { return cap_; }
+    // approximate if called in neither producer nor consumer thread
+    size_t size() const { return in_.load(std::memory_order_acquire) - out_.load(std::memory_order_acquire); }
+    bool empty() const { return size() == 0; }
+
+    // producer: contiguous space of writable() bytes
+    uint8_t* write_ptr() const { return data_ + in_.load(std::memory_order_relaxed) % cap_; }
+    size_t writable() const { return cap_ - (in_.load(std::memory_order_relaxed) - out_.load(std::memory_order_acquire)); }
+    // producer: publish n bytes written at write_ptr(), n <= writable()
+    void commit(size_t n) {
+        in_.store(in_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    // consumer: contiguous data of readable() bytes
+    const uint8_t* read_ptr() const { return data_ + out_.load(std::memory_order_relaxed) % cap_; }
+    size_t readable() const { return in_.load(std::memory_order_acquire) - out_.load(std::memory_order_relaxed); }
+    // consumer: free n bytes read at read_ptr(), n <= readable()
+    void consume(size_t n) {
+        out_.store(out_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+private:
+    [[noreturn]] static void fail(int fd, const char* what) {
+        const int e = errno;
+        close(fd);
+        throw std::system_error(e, std::generic_category(), what);
+    }
+
+    uint8_t* data_ = nullptr;
+    size_t cap_ = 0;
+    alignas(cacheline_size) std::atomic<size_t> in_ = {0};
+    alignas(cacheline_size) std::atomic<size_t> out_ = {0};
+};
+} // namespace lockless
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2026 WangBin <wbsecg1 at gmail.com>
+ * MIT License
+ * Lock Free Bounded MPMC FIFO
+ * https://github.com/wang-bin/lockless
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include "cacheline.h"
+#include "eventcount.h"
+#include "stats.h"
+
+// array based, no allocation after construction, no memory reclamation. http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+// every slot has a sequence number: seq == pos means writable for producer of pos, seq == pos + 1 means readable for consumer of pos
+template<typename T>
+struct mpmc_bounded_fifo_slot {
+    std::atomic<size_t> seq;
+    T v;
+};
+
+template<typename T, typename C, class Stats, class Wait>
+class mpmc_bounded_fifo_api : private Stats {
+public:
+    // return number of element cleared
+    int clear() {
+        int n = 0;
+        while (try_pop())
+            n++;
+        return n;
+    }
+
+    // return false if full
+    template<typename... Args>
+    bool try_emplace(Args&&... args) {
+        size_t pos = 0;
+        auto s = claim_push(pos);
+        if (!s)
+            return false;
+        s->v.~T(); // already default constructed, so destruct first
+        new (&s->v) T{std::forward<Args>(args)...};
+        s->seq.store(pos + 1, std::memory_order_release);
+        Stats::on_push();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    template<typename U>
+    bool try_push(U&& v) {
+        size_t pos = 0;
+        auto s = claim_push(pos);
+        if (!s)
+            return false;
+        s->v = std::forward<U>(v);
+        s->seq.store(pos + 1, std::memory_order_release); // publish to consumer of pos
+        Stats::on_push();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // return false if empty
+    bool try_pop(T* v = nullptr) {
+        size_t pos = out_.load(std::memory_order_relaxed);
+        slot* s = nullptr;
+        uint64_t retries = 0;
+        for (;; retries++) {
+            s = &data_[pos & mask()];
+            const size_t seq = s->seq.load(std::memory_order_acquire);
+            const intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (dif == 0) {
+                if (out_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (dif < 0) { // not written yet
+                Stats::on_cas_retry(retries);
+                Stats::on_pop_fail();
+                return false;
+            } else { // popped by another consumer
+                pos = out_.load(std::memory_order_relaxed);
+            }
+        }
+        Stats::on_cas_retry(retries);
+        if (v)
+            *v = std::move(s->v);
+        s->seq.store(pos + mask() + 1, std::memory_order_release); // writable for producer of next round
+        Stats::on_pop();
+        not_full_.notify_one();
+        return true;
+    }
+
+    lockless::queue_stats stats() const {
+        return Stats::snapshot();
+    }
+
+    // block until v is pushed
+    template<typename U>
+    void wait_push(U&& v) {
+        not_full_.await([&]{ return try_push(std::forward<U>(v)); }); // v is not moved if try_push() fails
+    }
+
+    // return false if v is not pushed before timeout
+    template<typename U, class Rep, class Period>
+    bool wait_push_for(U&& v, const std::chrono::duration<Rep, Period>& timeout) {
+        return not_full_.await_for([&]{ return try_push(std::forward<U>(v)); }, timeout);
+    }
+
+    // block until an element is popped
+    void wait_pop(T* v = nullptr) {
+        not_empty_.await([this, v]{ return try_pop(v); });
+    }
+
+    // return false if no element is popped before timeout
+    template<class Rep, class Period>
+    bool wait_pop_for(T* v, const std::chrono::duration<Rep, Period>& timeout) {
+        return not_empty_.await_for([this, v]{ return try_pop(v); }, timeout);
+    }
+
+    size_t capacity() const { return std::size(data_); }
+    // approximate
+    size_t size() const {
+        const size_t out = out_.load(std::memory_order_relaxed);
+        const size_t in = in_.load(std::memory_order_relaxed);
+        return in > out ? in - out : 0;
+    }
+    bool empty() const { return size() == 0;}
+protected:
+    using slot = mpmc_bounded_fifo_slot<T>;
+
+    void init() {
+        for (size_t i = 0; i < capacity(); ++i)
+            data_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    size_t mask() const { return capacity() - 1; } // capacity is power of 2
+
+    slot* claim_push(size_t& pos) {
+        pos = in_.load(std::memory_order_relaxed);
+        for (uint64_t retries = 0;; retries++) {
+            slot* s = &data_[pos & mask()];
+            const size_t seq = s->seq.load(std::memory_order_acquire);
+            const intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if (dif == 0) {
+                if (in_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    Stats::on_cas_retry(retries);
+                    return s;
+                }
+            } else if (dif < 0) { // not popped yet in last round
+                Stats::on_cas_retry(retries);
+                return nullptr;
+            } else { // pushed by another producer
+                pos = in_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    alignas(lockless::cacheline_size) std::atomic<size_t> in_ = {0};
+    alignas(lockless::cacheline_size) std::atomic<size_t> out_ = {0};
+    alignas(lockless::cacheline_size) Wait not_empty_; // read by every push and pop
+    Wait not_full_;
+    alignas(lockless::cacheline_size) C data_;
+};
+
+// capacity is rounded up to power of 2
+template<typename T, class Stats = lockless::null_stats, class Wait = lockless::spin_wait>
+class mpmc_bounded_fifo : public mpmc_bounded_fifo_api<T, std::vector<mpmc_bounded_fifo_slot<T>>, Stats, Wait> {
+    using api = mpmc_bounded_fifo_api<T, std::vector<mpmc_bounded_fifo_slot<T>>, Stats, Wait>;
+    using api::data_;
+public:
+    mpmc_bounded_fifo(size_t cap) : api() {
+        data_ = std::vector<mpmc_bounded_fifo_slot<T>>(round_up(cap)); // slot is not movable, can not resize()
+        api::init();
+    }
+private:
+    static size_t round_up(size_t v) {
+        size_t n = 2;
+        while (n < v)
+            n <<= 1;
+        return n;
+    }
+};
+
+template<typename T, int N, class Stats = lockless::null_stats, class Wait = lockless::spin_wait>
+class static_mpmc_bounded_fifo : public mpmc_bounded_fifo_api<T, mpmc_bounded_fifo_slot<T>[N], Stats, Wait> {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be power of 2");
+public:
+    static_mpmc_bounded_fifo() {
+        this->init();
+    }
+};
@@ -6,22 +6,27 @@
  */
 #pragma once
 #include <atomic>
+#include <memory>
 #include <utility>
+#include "eventcount.h"
+#include "stats.h"
+#include "hazard_pointer.h"
 
 #define MPMC_FIFO_RAW_NEXT_PTR 0 // raw ptr requires while(!compare_exchange...). FIXME: push wrror?
 
-template<typename T>
-class mpmc_fifo {
+// Allocator must be stateless(is_always_equal), e.g. std::allocator, lockless::slab_allocator
+template<typename T, class Stats = lockless::null_stats, class Allocator = std::allocator<T>, class Wait = lockless::spin_wait>
+class mpmc_fifo : private Stats {
 public:
     mpmc_fifo() {
-        node* n = new node();
+        node* n = new_node();
         out_.store(n);
         in_.store(n);
     }
 
     ~mpmc_fifo() {
         clear();
-        delete out_.load();
+        delete_node(out_.load());
     }
 
     // return number of element cleared
@@ -34,7 +39,7 @@ public:
 
     template<typename... Args>
     void emplace(Args&&... args) {
-        node *n = new node{std::forward<Args>(args)...};
+        node *n = new_node(std::forward<Args>(args)...);
 #if MPMC_FIFO_RAW_NEXT_PTR // slower?
         node* t = in_.load(std::memory_order_relaxed);
         do {
@@ -44,11 +49,13 @@ public:
         node* t = in_.exchange(n, std::memory_order_acq_rel);
         t->next.store(n, std::memory_order_release);
 #endif
+        Stats::on_push();
+        not_empty_.notify_one();
     }
 
     template<typename U>
     void push(U&& v) {
-        node *n = new node{std::forward<U>(v)};
+        node *n = new_node(std::forward<U>(v));
 #if MPMC_FIFO_RAW_NEXT_PTR // slower
         node* t = in_.load(std::memory_order_relaxed);
         do {
@@ -58,37 +65,101 @@ public:
         node* t = in_.exchange(n, std::memory_order_acq_rel);
         t->next.store(n, std::memory_order_release);
 #endif
+        Stats::on_push();
+        not_empty_.notify_one();
     }
 
-// recursive recycle
-    bool pop(T* v = nullptr) {
-        popping_++;
-        // will check next.load() later, also next.store() in push() must be after exchange, so relaxed is enough
-        node* out = out_.load(std::memory_order_relaxed);
-        node* n = nullptr;
-        do {
-            if (out == in_.load(std::memory_order_relaxed)) {// pop() by other consumer and now empty
-                popping_--;
-                return false;
+    // push [first, last) as a whole, elements are in order and not interleaved with other producers. return number of elements pushed
+    template<typename InputIt>
+    int push_range(InputIt first, InputIt last) {
+        if (first == last)
+            return 0;
+        node* h = new_node(*first);
+        node* e = h;
+        int count = 1;
+        try {
+            for (++first; first != last; ++first, ++count) { // private chain, no atomic operation required
+                node* n = new_node(*first);
+#if MPMC_FIFO_RAW_NEXT_PTR
+                e->next = n;
+#else
+                e->next.store(n, std::memory_order_relaxed);
+#endif
+                e = n;
             }
-            // if out is now deleted by another pop. atomic<shared_ptr<node>>?
+        } catch (...) { // T copy ctor throws, the chain is not published yet
+            while (h != e) {
 #if MPMC_FIFO_RAW_NEXT_PTR
-            n = out->next;
+                node* n = h->next;
 #else
-            n = out->next.load(std::memory_order_relaxed);
+                node* n = h->next.load(std::memory_order_relaxed);
 #endif
-            if (!n) {
-                popping_--;
-                return false;
+                delete_node(h);
+                h = n;
             }
-        } while (!out_.compare_exchange_weak(out, n));
+            delete_node(e);
+            throw;
+        }
+#if MPMC_FIFO_RAW_NEXT_PTR
+        node* t = in_.load(std::memory_order_relaxed);
+        do {
+            t->next = h;
+        } while (!in_.compare_exchange_weak(t, e, std::memory_order_acq_rel, std::memory_order_relaxed));
+#else
+        node* t = in_.exchange(e, std::memory_order_acq_rel);
+        t->next.store(h, std::memory_order_release); // publish the whole chain
+#endif
+        Stats::on_push(count);
+        not_empty_.notify_all();
+        return count;
+    }
+
+    bool pop(T* v = nullptr) {
+        lockless::hazard_guard hp;
+        node* n = pop_node(hp);
+        if (!n) {
+            Stats::on_pop_fail();
+            return false;
+        }
         if (v)
             *v = std::move(n->v);
-        try_delete(out);
+        Stats::on_pop();
         return true;
     }
+
+    // pop at most max elements to out. nodes are still popped one by one, but hazard record is acquired once. return number of elements popped
+    template<typename OutputIt>
+    int pop_batch(OutputIt out, int max) {
+        lockless::hazard_guard hp;
+        int count = 0;
+        for (; count < max; ++count) {
+            node* n = pop_node(hp);
+            if (!n)
+                break;
+            *out++ = std::move(n->v);
+        }
+        if (count)
+            Stats::on_pop(count);
+        else
+            Stats::on_pop_fail();
+        return count;
+    }
+
+    lockless::queue_stats stats() const {
+        return Stats::snapshot();
+    }
+
+    // block until an element is popped
+    void wait_pop(T* v = nullptr) {
+        not_empty_.await([this, v]{ return pop(v); });
+    }
+
+    // return false if no element is popped before timeout
+    template<class Rep, class Period>
+    bool wait_pop_for(T* v, const std::chrono::duration<Rep, Period>& timeout) {
+        return not_empty_.await_for([this, v]{ return pop(v); }, timeout);
+    }
 private:
-// TODO: node allocator, using mpmc_bounded_fifo(array)
     struct node {
         T v;
 #if MPMC_FIFO_RAW_NEXT_PTR
@@ -98,52 +169,61 @@ private:
 #endif
     };
 
-    void delete_pending(node* n) {
-        while (n) {
-            node *next = n->next;
-            delete n;
-            n = next;
+    using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<node>;
+    using node_traits = std::allocator_traits<node_allocator>;
+    static_assert(node_traits::is_always_equal::value, "retired nodes are deleted by any thread without the queue, so Allocator must be stateless");
+
+    template<typename... Args>
+    static node* new_node(Args&&... args) {
+        node_allocator a;
+        node* n = node_traits::allocate(a, 1);
+        try {
+            return ::new (n) node{std::forward<Args>(args)...};
+        } catch (...) {
+            node_traits::deallocate(a, n, 1);
+            throw;
         }
     }
 
-    void try_delete(node* n) {
-        if (popping_ == 1) {
-            node* ns = pending_delete_.exchange(nullptr);
-            if (!--popping_) // safe, another thread run into pop() now will not get a deleting out
-                delete_pending(ns);
-            else // 3 threads, t1 in try_delete before exchange(), t2  t3 just load() in pop() and get the same out, t3 finishes pop() first, t1 exchange and get t3 popped node, now popping_ is 2, if delete --popping>0, t2 later accesses invalid out
-                delete_later(ns); // can not delete (delete later appended reading node, so considering 3 threads is enough)
-            delete n;
-        } else {
-            delete_later(n, n);
-            popping_--;
-        }
+    static void delete_node(void* p) {
+        node_allocator a;
+        node* n = static_cast<node*>(p);
+        n->~node();
+        node_traits::deallocate(a, n, 1);
     }
 
-    void delete_later(node* begin, node* end) {
+    // return the new dummy node whose value is popped, it's protected by hp until next pop_node() or hp is destroyed
+    node* pop_node(lockless::hazard_guard& hp) {
+        node* out = nullptr;
+        node* n = nullptr;
+        uint64_t retries = 0;
+        for (;; retries++) {
+            out = hp.protect(0, out_); // out can not be deleted by another pop now
+            // will check next.load() later, also next.store() in push() must be after exchange, so relaxed is enough
+            if (out == in_.load(std::memory_order_relaxed)) // pop() by other consumer and now empty
+                break;
 #if MPMC_FIFO_RAW_NEXT_PTR
-        end->next = pending_delete_;
-        while (!pending_delete_.compare_exchange_weak(end->next, begin)) {}
+            n = out->next;
 #else
-        node* n = pending_delete_.exchange(begin);
-        end->next.store(n);
+            n = out->next.load(std::memory_order_acquire);
 #endif
-    }
-    void delete_later(node* n) {
-        if (!n)
-            return;
-        node* end = n;
-        while (node* const next = end->next) {
-            end = next;
+            if (!n)
+                break;
+            hp.set(1, n); // n is retired after out_ moves from out to n and then to n->next, so n is not retired if out_ is still out
+            if (out_.load(std::memory_order_acquire) == out && out_.compare_exchange_weak(out, n))
+                break;
+            n = nullptr;
         }
-        delete_later(n, end);
+        Stats::on_cas_retry(retries);
+        if (!n)
+            return nullptr;
+        hp.reset(0);
+        hp.retire(out, delete_node);
+        return n;
     }
 
     // TODO: aligas(hardware_destructive_interference_size)
-    std::atomic<node*> out_; // TODO: atomic<shared_ptr<node>> out_; get rid of memory management if lock free
+    std::atomic<node*> out_; // popped nodes are reclaimed by hazard pointers
     std::atomic<node*> in_; // can not use in_{out_} because atomic ctor with desired value MUST be constexpr (error in g++4.8 iff use template)
-    std::atomic<int> popping_{0};
-    std::atomic<node*> pending_delete_{nullptr};
-    //mpsc_fifo<node*> pending_delete_; // unsafe to clear in 3 comsumer threads
-    //mpmc_fifo<node*> reuse_; // mpmc_fifo<node*> *reuse_; // TODO: recursively reuse undeleted node in push() to slow down leak
+    Wait not_empty_;
 };
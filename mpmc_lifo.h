@@ -6,11 +6,22 @@
  */
 #pragma once
 #include <atomic>
+#include <memory>
+#include <type_traits>
 #include <utility>
+#include "eventcount.h"
+#include "hazard_pointer.h"
+#include "lifo_chain.h"
+#include "stats.h"
 
-template<typename T>
-class mpmc_lifo {
+// Allocator must be stateless(is_always_equal), e.g. std::allocator, lockless::slab_allocator
+template<typename T, class Stats = lockless::null_stats, class Allocator = std::allocator<T>, class Wait = lockless::spin_wait>
+class mpmc_lifo : private Stats {
+    struct node;
+    struct reclaim;
 public:
+    using chain = lockless::lifo_chain<T, node, reclaim>;
+
     ~mpmc_lifo() {
         clear();
     }
@@ -25,75 +36,128 @@ public:
 
     template<typename... Args>
     void emplace(Args&&... args) {
-        node *n = new node{std::forward<Args>(args)...};
-        n->next = io_.load();
-        while (!io_.compare_exchange_weak(n->next, n)) {}
+        node *n = new_node(std::forward<Args>(args)...);
+        node* h = io_.load();
+        n->next.store(h, std::memory_order_relaxed);
+        uint64_t retries = 0;
+        while (!io_.compare_exchange_weak(h, n)) {
+            n->next.store(h, std::memory_order_relaxed);
+            retries++;
+        }
+        Stats::on_cas_retry(retries);
+        Stats::on_push();
+        not_empty_.notify_one();
     }
 
     template<typename U>
     void push(U&& v) {
-        node *n = new node{std::forward<U>(v)};
-        n->next = io_.load();
-        while (!io_.compare_exchange_weak(n->next, n)) {}
+        node *n = new_node(std::forward<U>(v));
+        node* h = io_.load();
+        n->next.store(h, std::memory_order_relaxed);
+        uint64_t retries = 0;
+        while (!io_.compare_exchange_weak(h, n)) {
+            n->next.store(h, std::memory_order_relaxed);
+            retries++;
+        }
+        Stats::on_cas_retry(retries);
+        Stats::on_push();
+        not_empty_.notify_one();
     }
 
     bool pop(T* v = nullptr) {
-        popping_++;
-        node* out = io_.load(); // pop() in another thread & out can be null
-        while (out && !io_.compare_exchange_weak(out, out->next)) {}
-        if (!out) {// became empty in another thead pop()
-            popping_--;
-            return false;
+        lockless::hazard_guard hp;
+        node* out = nullptr;
+        uint64_t retries = 0;
+        for (;; retries++) {
+            out = hp.protect(0, io_); // out can not be deleted and then reused by push() now, so no ABA
+            if (!out) {// became empty in another thead pop()
+                Stats::on_cas_retry(retries);
+                Stats::on_pop_fail();
+                return false;
+            }
+            if (io_.compare_exchange_weak(out, out->next.load(std::memory_order_relaxed)))
+                break;
         }
+        Stats::on_cas_retry(retries);
+        Stats::on_pop();
         if (v)
             *v = std::move(out->v);
-        try_delete(out);
+        hp.clear();
+        hp.retire(out, delete_node);
         return true;
     }
+
+    // take all elements in 1 atomic operation, no ABA. the chain is newest first, call chain.reverse() for fifo order
+    chain pop_all() {
+        node* h = io_.exchange(nullptr, std::memory_order_acquire);
+        if (!h) {
+            Stats::on_pop_fail();
+            return chain();
+        }
+        if (!std::is_same<Stats, lockless::null_stats>::value) {
+            int n = 0;
+            for (node* i = h; i; i = i->next.load(std::memory_order_relaxed))
+                n++;
+            Stats::on_pop(n);
+        }
+        return chain(h);
+    }
+
+    lockless::queue_stats stats() const {
+        return Stats::snapshot();
+    }
+
+    // block until an element is popped
+    void wait_pop(T* v = nullptr) {
+        not_empty_.await([this, v]{ return pop(v); });
+    }
+
+    // return false if no element is popped before timeout
+    template<class Rep, class Period>
+    bool wait_pop_for(T* v, const std::chrono::duration<Rep, Period>& timeout) {
+        return not_empty_.await_for([this, v]{ return pop(v); }, timeout);
+    }
 private:
     struct node {
         T v;
-        node* next;
+        std::atomic<node*> next; // a pop() failed to CAS may read it while the chain of pop_all() is reversed
     };
 
-    void delete_pending(node* n) {
-        while (n) {
-            node *next = n->next;
-            delete n;
-            n = next;
-        }
-    }
+    using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<node>;
+    using node_traits = std::allocator_traits<node_allocator>;
+    static_assert(node_traits::is_always_equal::value, "retired nodes are deleted by any thread without the queue, so Allocator must be stateless");
 
-    void try_delete(node* n) {
-        if (popping_ == 1) {
-            node* ns = pending_delete_.exchange(nullptr);
-            if (!--popping_) // safe, another thread run into pop() now will not get a deleting out
-                delete_pending(ns);
-            else // 3 threads, t1 in try_delete before exchange(), t2  t3 just load() in pop() and get the same out, t3 finishes pop() first, t1 exchange and get t3 popped node, now popping_ is 2, if delete --popping>0, t2 later accesses invalid out
-                delete_later(ns); // can not delete (delete later appended reading node, so considering 3 threads is enough)
-            delete n;
-        } else {
-            delete_later(n, n);
-            popping_--;
+    template<typename... Args>
+    static node* new_node(Args&&... args) {
+        node_allocator a;
+        node* n = node_traits::allocate(a, 1);
+        try {
+            return ::new (n) node{std::forward<Args>(args)...};
+        } catch (...) {
+            node_traits::deallocate(a, n, 1);
+            throw;
         }
     }
 
-    void delete_later(node* begin, node* end) {
-        end->next = pending_delete_;
-        while (!pending_delete_.compare_exchange_weak(end->next, begin)) {}
+    static void delete_node(void* p) {
+        node_allocator a;
+        node* n = static_cast<node*>(p);
+        n->~node();
+        node_traits::deallocate(a, n, 1);
     }
-    void delete_later(node* n) {
-        if (!n)
-            return;
-        node* end = n;
-        while (node* const next = end->next) {
-            end = next;
+
+    struct reclaim { // a node may be still protected by a pop() failed to CAS
+        static void release(node* n) {
+            lockless::hazard_guard hp;
+            while (n) {
+                node* next = n->next.load(std::memory_order_relaxed);
+                hp.retire(n, delete_node);
+                n = next;
+            }
         }
-        delete_later(n, end);
-    }
+    };
 
 // = {} not {}: fix g++4.8 atomic copy ctor error in compiler generated default ctor if atomic member is direct list initialized (class template only)
     std::atomic<node*> io_ = {nullptr};
-    std::atomic<node*> pending_delete_ = {nullptr};
-    std::atomic<int> popping_ = {0};
+    Wait not_empty_;
 };
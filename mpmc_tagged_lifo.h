@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2026 WangBin <wbsecg1 at gmail.com>
+ * MIT License
+ * Lock Free MPMC LIFO, ABA safe
+ * https://github.com/wang-bin/lockless
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include "eventcount.h"
+#include "stats.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// nodes live in a growable arena and never return to the heap until destruction, so a node can be reused as soon as it's popped.
+// head is {index, tag} in 1 64bit word, tag is increased by every successful CAS, so a stale head can not match(ABA) unless tag wraps(2^32 operations)
+// a stale pop may read next of a reused node, it's harmless because the CAS will fail.
+template<typename T, class Stats = lockless::null_stats, class Wait = lockless::spin_wait>
+class mpmc_tagged_lifo : private Stats {
+public:
+    ~mpmc_tagged_lifo() {
+        clear();
+        for (auto& c : chunks_)
+            delete[] c.load();
+    }
+
+    // return number of element cleared
+    int clear() {
+        int n = 0;
+        while (pop())
+            n++;
+        return n;
+    } // in consumer thread
+
+    template<typename... Args>
+    void emplace(Args&&... args) {
+        const uint32_t i = allocate();
+        new (at(i)->storage) T{std::forward<Args>(args)...};
+        Stats::on_cas_retry(push_index(io_, i));
+        Stats::on_push();
+        not_empty_.notify_one();
+    }
+
+    template<typename U>
+    void push(U&& v) {
+        const uint32_t i = allocate();
+        new (at(i)->storage) T(std::forward<U>(v));
+        Stats::on_cas_retry(push_index(io_, i));
+        Stats::on_push();
+        not_empty_.notify_one();
+    }
+
+    bool pop(T* v = nullptr) {
+        uint64_t retries = 0;
+        const uint32_t i = pop_index(io_, retries);
+        Stats::on_cas_retry(retries);
+        if (i == null_index) {
+            Stats::on_pop_fail();
+            return false;
+        }
+        T* p = at(i)->value();
+        if (v)
+            *v = std::move(*p);
+        p->~T();
+        push_index(free_, i); // reuse immediately
+        Stats::on_pop();
+        return true;
+    }
+
+    lockless::queue_stats stats() const {
+        return Stats::snapshot();
+    }
+
+    // block until an element is popped
+    void wait_pop(T* v = nullptr) {
+        not_empty_.await([this, v]{ return pop(v); });
+    }
+
+    // return false if no element is popped before timeout
+    template<class Rep, class Period>
+    bool wait_pop_for(T* v, const std::chrono::duration<Rep, Period>& timeout) {
+        return not_empty_.await_for([this, v]{ return pop(v); }, timeout);
+    }
+private:
+    static constexpr uint32_t null_index = UINT32_MAX;
+    static constexpr uint32_t chunk0_size = 64; // chunk k has chunk0_size << k nodes
+    static constexpr int max_chunks = 26; // chunk0_size * (2^26 - 1) nodes < 2^32
+
+    struct node {
+        std::atomic<uint32_t> next = {null_index};
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* value() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    static uint64_t pack(uint32_t index, uint32_t tag) { return (uint64_t(tag) << 32) | index; }
+    static uint32_t index_of(uint64_t head) { return uint32_t(head); }
+    static uint32_t tag_of(uint64_t head) { return uint32_t(head >> 32); }
+
+    static int log2(uint32_t v) {
+#if defined(_MSC_VER)
+        unsigned long r = 0;
+        _BitScanReverse(&r, v);
+        return (int)r;
+#else
+        return 31 - __builtin_clz(v);
+#endif
+    }
+
+    node* at(uint32_t i) const {
+        const int k = log2(i/chunk0_size + 1);
+        return chunks_[k].load(std::memory_order_acquire) + (i - chunk0_size*((1u << k) - 1));
+    }
+
+    uint32_t allocate() {
+        uint64_t retries = 0;
+        uint32_t i = pop_index(free_, retries);
+        if (i != null_index)
+            return i;
+        i = size_.fetch_add(1, std::memory_order_relaxed);
+        const int k = log2(i/chunk0_size + 1);
+        if (k >= max_chunks)
+            throw std::bad_alloc();
+        if (!chunks_[k].load(std::memory_order_acquire)) {
+            node* c = new node[size_t(chunk0_size) << k];
+            node* expected = nullptr;
+            if (!chunks_[k].compare_exchange_strong(expected, c, std::memory_order_acq_rel)) // allocated by another push
+                delete[] c;
+        }
+        return i;
+    }
+
+    // return number of failed CAS
+    uint64_t push_index(std::atomic<uint64_t>& head, uint32_t i) {
+        node* n = at(i);
+        uint64_t h = head.load(std::memory_order_relaxed);
+        uint64_t retries = 0;
+        for (;; retries++) {
+            n->next.store(index_of(h), std::memory_order_relaxed);
+            if (head.compare_exchange_weak(h, pack(i, tag_of(h) + 1), std::memory_order_release, std::memory_order_relaxed))
+                return retries;
+        }
+    }
+
+    uint32_t pop_index(std::atomic<uint64_t>& head, uint64_t& retries) {
+        uint64_t h = head.load(std::memory_order_acquire);
+        for (;; retries++) {
+            const uint32_t i = index_of(h);
+            if (i == null_index)
+                return i;
+            const uint32_t next = at(i)->next.load(std::memory_order_relaxed);
+            if (head.compare_exchange_weak(h, pack(next, tag_of(h) + 1), std::memory_order_acquire, std::memory_order_acquire))
+                return i;
+        }
+    }
+
+// = {} not {}: fix g++4.8 atomic copy ctor error in compiler generated default ctor if atomic member is direct list initialized (class template only)
+    std::atomic<uint64_t> io_ = {pack(null_index, 0)};
+    std::atomic<uint64_t> free_ = {pack(null_index, 0)};
+    std::atomic<uint32_t> size_ = {0}; // arena nodes ever allocated
+    Wait not_empty_;
+    std::atomic<node*> chunks_[max_chunks] = {};
+};
@@ -6,18 +6,24 @@
  */
 #pragma once
 #include <atomic>
+#include <memory>
 #include <utility>
+#include "eventcount.h"
+#include "stats.h"
 
 #define MPSC_FIFO_RAW_NEXT_PTR 0
 
-template<typename T>
-class mpsc_fifo {
+template<typename T, class Stats = lockless::null_stats, class Allocator = std::allocator<T>, class Wait = lockless::spin_wait>
+class mpsc_fifo : private Stats {
 public:
-    mpsc_fifo() { in_.store(out_); }
+    mpsc_fifo(const Allocator& a = Allocator()) : alloc_(a) {
+        out_ = new_node();
+        in_.store(out_);
+    }
 
     ~mpsc_fifo() {
         clear();
-        delete out_;
+        delete_node(out_);
     }
 
     // return number of element cleared
@@ -30,7 +36,7 @@ public:
 
     template<typename... Args>
     void emplace(Args&&... args) {
-        node *n = new node{std::forward<Args>(args)...};
+        node *n = new_node(std::forward<Args>(args)...);
 #if MPSC_FIFO_RAW_NEXT_PTR // slower
         node* t = in_.load(std::memory_order_relaxed);
         do {
@@ -40,11 +46,13 @@ public:
         node* t = in_.exchange(n, std::memory_order_acq_rel);
         t->next.store(n, std::memory_order_release);
 #endif
+        Stats::on_push();
+        not_empty_.notify_one();
     }
 
     template<typename U>
     void push(U&& v) {
-        node *n = new node{std::forward<U>(v)};
+        node *n = new_node(std::forward<U>(v));
 #if MPSC_FIFO_RAW_NEXT_PTR // slower
         node* t = in_.load(std::memory_order_relaxed);
         do {
@@ -54,25 +62,116 @@ public:
         node* t = in_.exchange(n, std::memory_order_acq_rel);
         t->next.store(n, std::memory_order_release);
 #endif
+        Stats::on_push();
+        not_empty_.notify_one();
+    }
+
+    // push [first, last) as a whole, elements are in order and not interleaved with other producers. return number of elements pushed
+    template<typename InputIt>
+    int push_range(InputIt first, InputIt last) {
+        if (first == last)
+            return 0;
+        node* h = new_node(*first);
+        node* e = h;
+        int count = 1;
+        try {
+            for (++first; first != last; ++first, ++count) { // private chain, no atomic operation required
+                node* n = new_node(*first);
+#if MPSC_FIFO_RAW_NEXT_PTR
+                e->next = n;
+#else
+                e->next.store(n, std::memory_order_relaxed);
+#endif
+                e = n;
+            }
+        } catch (...) { // T copy ctor throws, the chain is not published yet
+            while (h != e) {
+#if MPSC_FIFO_RAW_NEXT_PTR
+                node* n = h->next;
+#else
+                node* n = h->next.load(std::memory_order_relaxed);
+#endif
+                delete_node(h);
+                h = n;
+            }
+            delete_node(e);
+            throw;
+        }
+#if MPSC_FIFO_RAW_NEXT_PTR
+        node* t = in_.load(std::memory_order_relaxed);
+        do {
+            t->next = h;
+        } while (!in_.compare_exchange_weak(t, e, std::memory_order_acq_rel, std::memory_order_relaxed));
+#else
+        node* t = in_.exchange(e, std::memory_order_acq_rel);
+        t->next.store(h, std::memory_order_release); // publish the whole chain
+#endif
+        Stats::on_push(count);
+        not_empty_.notify_one();
+        return count;
     }
 
     bool pop(T* v = nullptr) {
         // will check next.load() later, also next.store() in push() must be after exchange, so relaxed is enough
-        if (out_ == in_.load(std::memory_order_relaxed)) //if (!out_->next) // not completely write to out_->next (t->next.store()), next is not null but invalid
+        if (out_ == in_.load(std::memory_order_relaxed)) {//if (!out_->next) // not completely write to out_->next (t->next.store()), next is not null but invalid
+            Stats::on_pop_fail();
             return false;
+        }
 #if MPSC_FIFO_RAW_NEXT_PTR
         node *n = out_->next;
 #else
         node *n = out_->next.load(std::memory_order_relaxed);
 #endif
-        if (!n) // before t->next.store() after in_.exchange() in push()
+        if (!n) {// before t->next.store() after in_.exchange() in push()
+            Stats::on_pop_fail();
             return false;
+        }
         if (v)
             *v = std::move(n->v);
-        delete out_;
+        delete_node(out_);
         out_ = n;
+        Stats::on_pop();
         return true;
     }
+    // pop at most max elements to out, only walks next pointers. return number of elements popped
+    template<typename OutputIt>
+    int pop_batch(OutputIt out, int max) {
+        int count = 0;
+        node* o = out_;
+        for (; count < max; ++count) {
+#if MPSC_FIFO_RAW_NEXT_PTR
+            node *n = o->next;
+#else
+            node *n = o->next.load(std::memory_order_acquire);
+#endif
+            if (!n) // empty, or before t->next.store() after in_.exchange() in push()
+                break;
+            *out++ = std::move(n->v);
+            delete_node(o);
+            o = n;
+        }
+        out_ = o;
+        if (count)
+            Stats::on_pop(count);
+        else
+            Stats::on_pop_fail();
+        return count;
+    }
+
+    lockless::queue_stats stats() const {
+        return Stats::snapshot();
+    }
+
+    // block until an element is popped
+    void wait_pop(T* v = nullptr) {
+        not_empty_.await([this, v]{ return pop(v); });
+    }
+
+    // return false if no element is popped before timeout
+    template<class Rep, class Period>
+    bool wait_pop_for(T* v, const std::chrono::duration<Rep, Period>& timeout) {
+        return not_empty_.await_for([this, v]{ return pop(v); }, timeout);
+    }
 private:
     struct node {
         T v;
@@ -83,6 +182,27 @@ private:
 #endif
     };
 
-    node *out_ = new node();
+    using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<node>;
+    using node_traits = std::allocator_traits<node_allocator>;
+
+    template<typename... Args>
+    node* new_node(Args&&... args) {
+        node* n = node_traits::allocate(alloc_, 1);
+        try {
+            return ::new (n) node{std::forward<Args>(args)...};
+        } catch (...) {
+            node_traits::deallocate(alloc_, n, 1);
+            throw;
+        }
+    }
+
+    void delete_node(node* n) {
+        n->~node();
+        node_traits::deallocate(alloc_, n, 1);
+    }
+
+    node_allocator alloc_;
+    node *out_ = nullptr;
     std::atomic<node*> in_; // can not use in_{out_} because atomic ctor with desired value MUST be constexpr (error in g++4.8 iff use template)
+    Wait not_empty_;
 };
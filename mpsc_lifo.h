@@ -6,11 +6,21 @@
  */
 #pragma once
 #include <atomic>
+#include <memory>
 #include <utility>
+#include "eventcount.h"
+#include "lifo_chain.h"
+#include "stats.h"
 
-template<typename T>
-class mpsc_lifo {
+template<typename T, class Stats = lockless::null_stats, class Allocator = std::allocator<T>, class Wait = lockless::spin_wait>
+class mpsc_lifo : private Stats {
+    struct node;
+    struct reclaim;
 public:
+    using chain = lockless::lifo_chain<T, node, reclaim>;
+
+    mpsc_lifo(const Allocator& a = Allocator()) : alloc_(a) {}
+
     ~mpsc_lifo() {
         clear();
     }
@@ -25,42 +35,122 @@ public:
 
     template<typename... Args>
     void emplace(Args&&... args) {
-        node *n = new node{std::forward<Args>(args)...};
+        node *n = new_node(std::forward<Args>(args)...);
         n->next = io_.load();
-        while (!io_.compare_exchange_weak(n->next, n)) {}
+        uint64_t retries = 0;
+        while (!io_.compare_exchange_weak(n->next, n))
+            retries++;
         count_++;
+        Stats::on_cas_retry(retries);
+        Stats::on_push();
+        not_empty_.notify_one();
     }
 
     template<typename U>
     void push(U&& v) {
-        node *n = new node{std::forward<U>(v)};
+        node *n = new_node(std::forward<U>(v));
         n->next = io_.load(); // next can be a raw ptr
-        while (!io_.compare_exchange_weak(n->next, n)) {}
+        uint64_t retries = 0;
+        while (!io_.compare_exchange_weak(n->next, n))
+            retries++;
         count_++;
+        Stats::on_cas_retry(retries);
+        Stats::on_push();
+        not_empty_.notify_one();
     }
 
     bool pop(T* v = nullptr) {
         node* out = io_.load(std::memory_order_relaxed);
-        if (!out)
+        if (!out) {
+            Stats::on_pop_fail();
             return false;
+        }
         // io_ can be modified in push(), so compare is required
-        while (!io_.compare_exchange_weak(out, out->next)) {}
+        uint64_t retries = 0;
+        while (!io_.compare_exchange_weak(out, out->next))
+            retries++;
+        Stats::on_cas_retry(retries);
+        Stats::on_pop();
         if (v)
             *v = std::move(out->v);
-        delete out;
+        delete_node(out);
         count_--;
         return true;
     }
 
+    // take all elements in 1 atomic operation. the chain is newest first, call chain.reverse() for fifo order
+    chain pop_all() {
+        node* h = io_.exchange(nullptr, std::memory_order_acquire);
+        if (!h) {
+            Stats::on_pop_fail();
+            return chain();
+        }
+        int n = 0;
+        for (node* i = h; i; i = i->next)
+            n++;
+        count_ -= n;
+        Stats::on_pop(n);
+        return chain(h, reclaim{alloc_});
+    }
+
     int size() const {
         return count_;
     }
+
+    lockless::queue_stats stats() const {
+        return Stats::snapshot();
+    }
+
+    // block until an element is popped
+    void wait_pop(T* v = nullptr) {
+        not_empty_.await([this, v]{ return pop(v); });
+    }
+
+    // return false if no element is popped before timeout
+    template<class Rep, class Period>
+    bool wait_pop_for(T* v, const std::chrono::duration<Rep, Period>& timeout) {
+        return not_empty_.await_for([this, v]{ return pop(v); }, timeout);
+    }
 private:
     struct node {
         T v;
         node* next;
     };
 
+    using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<node>;
+    using node_traits = std::allocator_traits<node_allocator>;
+
+    struct reclaim { // single consumer, no other thread can access popped nodes
+        node_allocator alloc;
+
+        void release(node* n) {
+            while (n) {
+                node* next = n->next;
+                n->~node();
+                node_traits::deallocate(alloc, n, 1);
+                n = next;
+            }
+        }
+    };
+
+    template<typename... Args>
+    node* new_node(Args&&... args) {
+        node* n = node_traits::allocate(alloc_, 1);
+        try {
+            return ::new (n) node{std::forward<Args>(args)...};
+        } catch (...) {
+            node_traits::deallocate(alloc_, n, 1);
+            throw;
+        }
+    }
+
+    void delete_node(node* n) {
+        n->~node();
+        node_traits::deallocate(alloc_, n, 1);
+    }
+
+    node_allocator alloc_;
     std::atomic<node*> io_{nullptr};
     std::atomic<int> count_{0};
+    Wait not_empty_;
 };
@@ -5,97 +5,156 @@
  * https://github.com/wang-bin/lockless
  */
 #pragma once
+#include <algorithm>
 #include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
 #include <utility>
 #include <vector>
-#include "cppcompat/iterator.hpp"
-// TODO: test apis
 
+// overwrite ring, e.g. latest N samples. a producer takes a ticket by fetch_add, and writes slot ticket % capacity, so push is O(1) for any number of producers.
+// slot stamp is (ticket + 1) << 2 | state. a writer claims the slot by CAS, and drops its sample if the slot is being written by another producer or already has a newer ticket.
+// consumer reads tickets in order like a seqlock: read stamp, copy value, read stamp again. a ticket is skipped if the slot has a newer ticket(overwritten) or the writer dropped it.
+// values are stored as atomic words, so T must be trivially copyable.
+// no in place claim()/front_claim() like lockless::ring: a slot may be overwritten while the consumer reads it, so a value must be copied out and validated
 namespace lockless {
 namespace mpsc { // policy?
 
+template<typename T>
+struct ring_slot {
+    static constexpr size_t word_count = (sizeof(T) + sizeof(uintptr_t) - 1)/sizeof(uintptr_t);
+
+    std::atomic<uint64_t> stamp = {0}; // 0: never written
+    std::atomic<uint64_t> skip = {0}; // max dropped ticket + 1
+    std::atomic<uintptr_t> words[word_count] = {};
+};
+
 template<typename T, typename C>
 class ring_api {
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
 public:
     void clear() { while (pop()) {}} // in consumer thread
 
-    template<typename U>
-    bool push(U&& t) {
-        auto in = in_.load(std::memory_order_relaxed);
-        // can not use exchange because depending on old in, producers may have the same old in value
-        while (!in_.compare_exchange_weak(in, index(in+1))) {} // TODO: spsc exchange()
-        data_[in] = std::forward<U>(t);
-        return try_update_out_index(in);
+    // return false if the sample is dropped because the slot is busy or overwritten by a newer ticket, or an old sample is overwritten
+    bool push(const T& t) {
+        const uint64_t ticket = in_.fetch_add(1, std::memory_order_relaxed);
+        auto& s = data_[index(ticket)];
+        uint64_t st = s.stamp.load(std::memory_order_relaxed);
+        if ((st & writing) || (st && ticket_of(st) > ticket) || !s.stamp.compare_exchange_strong(st, stamp(ticket, writing), std::memory_order_relaxed)) {
+            mark_skip(s, ticket);
+            return false;
+        }
+        std::atomic_thread_fence(std::memory_order_release); // writing stamp is visible before words
+        uintptr_t w[ring_slot<T>::word_count] = {};
+        memcpy(w, &t, sizeof(T));
+        for (size_t i = 0; i < ring_slot<T>::word_count; ++i)
+            s.words[i].store(w[i], std::memory_order_relaxed);
+        s.stamp.store(stamp(ticket, done), std::memory_order_release);
+        return ticket < out_.load(std::memory_order_relaxed) + capacity();
     }
 
     template<typename... Args>
     bool emplace(Args&&... args) {
-//        static_assert(std::is_array<C>::value, "only static_ring supports emplace(...)");
-        auto in = in_.load(std::memory_order_relaxed);
-        while (!in_.compare_exchange_weak(in, index(in+1))) {}
-        data_[in_].~T(); // already default constructed, so destruct first
-        new (&data_[in]) T{std::forward<Args>(args)...};
-        return try_update_out_index(in);
+        return push(T{std::forward<Args>(args)...});
     }
 
+    // return number of unread tickets including the popped one, or 0 if no value is ready
     int pop(T* v = nullptr) {
-        auto out = out_.load(std::memory_order_relaxed);
-        auto in = in_.load(std::memory_order_relaxed);
-        if (out == in) // mpsc only?
-            return 0;
-        // push() may overlap out index
-        while (!out_.compare_exchange_weak(out, index(out+1))) {
-            in = in_.load(std::memory_order_relaxed);
+        uint64_t out = out_.load(std::memory_order_relaxed);
+        for (;;) {
+            const uint64_t in = in_.load(std::memory_order_acquire);
+            if (out + capacity() < in) // overwritten
+                out = in - capacity();
+            if (out == in)
+                break;
+            auto& s = data_[index(out)];
+            const uint64_t st = s.stamp.load(std::memory_order_acquire);
+            if (st == 0 || ticket_of(st) < out) { // not written yet
+                if (s.skip.load(std::memory_order_acquire) > out) { // dropped, or newer ticket is dropped so out is overwritten
+                    out++;
+                    continue;
+                }
+                break;
+            }
+            if (ticket_of(st) > out) { // overwritten
+                out++;
+                continue;
+            }
+            if (st & writing) // being written
+                break;
+            uintptr_t w[ring_slot<T>::word_count];
+            for (size_t i = 0; i < ring_slot<T>::word_count; ++i)
+                w[i] = s.words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.stamp.load(std::memory_order_relaxed) != st) { // overwritten while copying
+                out++;
+                continue;
+            }
+            if (v)
+                memcpy(v, w, sizeof(T));
+            out_.store(out + 1, std::memory_order_relaxed);
+            return int(in - out);
         }
-        if (v)
-            *v = data_[out];
-        data_[out] = T(); //erase the old data. can not ~T() because the uninitialized object may be used in front()
-        return size(in, out);
+        out_.store(out, std::memory_order_relaxed);
+        return 0;
     }
 
-    int capacity() const { return int(std::size(data_) - 1); }
-    int size() const { return size(in_.load(std::memory_order_relaxed), out_.load(std::memory_order_relaxed));}
+    int capacity() const { return int(std::size(data_)); }
+    // approximate
+    int size() const {
+        const uint64_t in = in_.load(std::memory_order_relaxed);
+        const uint64_t out = out_.load(std::memory_order_relaxed);
+        return in > out ? int(std::min<uint64_t>(in - out, capacity())) : 0;
+    }
     bool empty() const { return size() == 0;}
-    const T &at(size_t i) const { return data_[index(out_+i)];}
-    const T &operator[](size_t i) const { return at(i);}
-    T &operator[](size_t i) { return data_[index(out_+i)];}
+    // number of tickets taken by producers
+    uint64_t pushed() const { return in_.load(std::memory_order_relaxed); }
+
+    // f(const T&) for every completely written slot, in slot order
     template<typename F>
-    void dump(F&& f) {
-        for (const auto& i : data_) {
-            f(i);
+    void dump(F&& f) const {
+        for (const auto& s : data_) {
+            const uint64_t st = s.stamp.load(std::memory_order_acquire);
+            if (st == 0 || (st & writing))
+                continue;
+            uintptr_t w[ring_slot<T>::word_count];
+            for (size_t i = 0; i < ring_slot<T>::word_count; ++i)
+                w[i] = s.words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.stamp.load(std::memory_order_relaxed) != st)
+                continue;
+            T v;
+            memcpy(&v, w, sizeof(T));
+            f(v);
         }
     }
 protected:
-    int extent() const { return capacity() + 1; }
-    int index(int i) const { return i < extent() ? i : i - extent();} // i is always in [0,extent())
-    int size(int in, int out) const {
-        const int i_o = in - out; // size_t diff is size_t, but we need signed int
-        return i_o < 0 ? extent() + i_o : i_o;
-    }
-    bool try_update_out_index(int in) {
-        auto out = out_.load(std::memory_order_relaxed);
-        if (size(in, out) == capacity()) {
-            while (!out_.compare_exchange_weak(out, index(out+1))) { // FIXME
-                if (size(in_.load(std::memory_order_relaxed), out) < capacity())
-                    break;
-            }
-            return false;
-        }
-        return true;
+    enum : uint64_t { done = 0, writing = 1 };
+
+    static uint64_t stamp(uint64_t ticket, uint64_t state) { return (ticket + 1) << 2 | state; }
+    static uint64_t ticket_of(uint64_t stamp) { return (stamp >> 2) - 1; } // stamp != 0
+
+    size_t index(uint64_t ticket) const { return size_t(ticket % std::size(data_)); }
+
+    static void mark_skip(ring_slot<T>& s, uint64_t ticket) {
+        uint64_t k = s.skip.load(std::memory_order_relaxed);
+        while (k < ticket + 1 && !s.skip.compare_exchange_weak(k, ticket + 1, std::memory_order_release, std::memory_order_relaxed)) {}
     }
 
-//  [1, 2, ..., cap, extent]
-    std::atomic<int> out_;
-    std::atomic<int> in_;
+    std::atomic<uint64_t> in_ = {0}; // next ticket
+    std::atomic<uint64_t> out_ = {0}; // next ticket to read. written by consumer only
     C data_;
 };
 
 template<typename T>
-class ring : public ring_api<T, std::vector<T>> {
-    using api = ring_api<T, std::vector<T>>;
+class ring : public ring_api<T, std::vector<ring_slot<T>>> {
+    using api = ring_api<T, std::vector<ring_slot<T>>>;
     using api::data_; // why need this?
 public:
-    ring(size_t cap = 0) : ring_api<T, std::vector<T>>() {
+    ring(size_t cap = 0) : api() {
         reserve(cap);
     }
     // resize: reserve space if necessary, and push elements to reach given size
@@ -110,18 +169,21 @@ public:
         for (int i = 0; i < n - value; ++i)
             api::pop();
     }
+    // not thread safe, all values are discarded
     void reserve(size_t cap) {
-        data_.reserve(cap + 1);
-        data_.resize(cap + 1);
+        if (cap <= data_.size())
+            return;
+        data_ = std::vector<ring_slot<T>>(cap); // slot is not movable
+        api::in_.store(0, std::memory_order_relaxed);
+        api::out_.store(0, std::memory_order_relaxed);
     }
 };
 
 template<typename T, int N>
-class static_ring : public ring_api<T, T[N+1]> {
-    using api = ring_api<T, T[N+1]>;
-    using ring_api<T, T[N+1]>::data_; // why need this?
+class static_ring : public ring_api<T, ring_slot<T>[N]> {
+    using api = ring_api<T, ring_slot<T>[N]>;
 public:
-    static_ring() : ring_api<T, T[N+1]>() {}
+    static_ring() : api() {}
     // resize: push elements to reach given size. can not larger than capacity()
     void resize(int value) {
         assert(value <= api::capacity());
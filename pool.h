@@ -7,79 +7,343 @@
 #pragma once
 #include <atomic>
 #include <cassert>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <utility>
+#include <vector>
 #include "mpmc_lifo.h"
 #include "mpsc_lifo.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
-template<typename T, template<typename> class C,  int PoolSize = 16>
+// get() and recycling take objects from and put to a magazine(array of MagazineSize objects) cached by current thread, touching no shared data.
+// a thread caches 2 magazines(loaded and spare) for each pool, and exchanges a whole magazine with the shared lifo only if both are empty(get) or full(put)
+// magazines cached by an exited thread are reused by the next new thread, or moved to the shared lifo by get() if the shared lifo is empty
+// get2() claims a slot of fixed pool by a bit in 64bit occupancy words(find first zero + atomic or), starting from the word last used by current thread
+template<typename T, template<typename> class C,  int PoolSize = 16, int MagazineSize = 32>
 class pool { // consumer thread can be producer thread, so availble models are single thread, mpsc, mpmc
 public:
+    pool() : id_(next_id()) {
+        for (auto& w : used_)
+            w.store(0, std::memory_order_relaxed);
+        if (PoolSize % 64)
+            used_[fixed_words - 1].store(~0ULL << (PoolSize % 64), std::memory_order_relaxed); // not existing slots are always used
+    }
+
     ~pool() {
         clear();
+        // no thread is using this pool now. objects in caches of alive threads are deleted too
+        for (local* l = locals_.load(std::memory_order_acquire); l;) {
+            local* next = l->next;
+            for (magazine* m : {l->loaded, l->spare}) {
+                if (!m)
+                    continue;
+                for (int i = 0; i < m->count; ++i)
+                    deleter_(m->items[i]);
+                delete m;
+            }
+            l->loaded = l->spare = nullptr;
+            l->release();
+            l = next;
+        }
+        magazine* m = nullptr;
+        while (empty_.pop(&m))
+            delete m;
     }
 
     void set_deleter(std::function<void(T*)> deleter) {
         deleter_ = deleter;
     }
 
+    // objects cached by other alive threads are not cleared
     int clear() {
         int n = 0;
-        for (auto& p : fixed_pool_) {
-            if (p.v) {
-                deleter_(p.v); //
-                p.v = nullptr;
+        for (auto& v : fixed_pool_) {
+            if (v) {
+                deleter_(v); //
+                v = nullptr;
                 n++;
             }
         }
-        T* t = nullptr;
-        while (pool_.pop(&t)) {
-            deleter_(t);
-            n++;
+        if (local* l = find_local())
+            flush(*l);
+        reclaim();
+        magazine* m = nullptr;
+        while (full_.pop(&m)) {
+            for (int i = 0; i < m->count; ++i)
+                deleter_(m->items[i]);
+            n += m->count;
+            m->count = 0;
+            empty_.push(m);
         }
         return n;
     } // in consumer thread
 
+    // move-only owner of an object from the pool, recycles the object when destroyed. no allocation, no type erased deleter
+    class handle {
+    public:
+        handle() = default;
+        handle(handle&& o) noexcept : v_(o.v_), pool_(o.pool_), slot_(o.slot_) { o.v_ = nullptr; }
+        handle& operator=(handle&& o) noexcept {
+            if (this != &o) {
+                reset();
+                v_ = o.v_;
+                pool_ = o.pool_;
+                slot_ = o.slot_;
+                o.v_ = nullptr;
+            }
+            return *this;
+        }
+        handle(const handle&) = delete;
+        handle& operator=(const handle&) = delete;
+        ~handle() { reset(); }
+
+        T* get() const { return v_; }
+        T& operator*() const { return *v_; }
+        T* operator->() const { return v_; }
+        explicit operator bool() const { return !!v_; }
+
+        // give the object back to pool
+        void reset() {
+            if (v_)
+                pool_->recycle(v_, slot_);
+            v_ = nullptr;
+        }
+    private:
+        friend class pool;
+        handle(T* v, const pool* p, int slot) : v_(v), pool_(p), slot_(slot) {}
+
+        T* v_ = nullptr;
+        const pool* pool_ = nullptr;
+        int slot_ = -1; // index of fixed_pool_, or -1 if from magazines
+    };
+
     /*!
       \brief get
       fetch an object from pool, or create one if pool is empty
       \param f object T creator
       \param args... parameters of f
-      \return unique_ptr of T
+      \return handle of T
      */
-    using tracked_ptr = std::unique_ptr<T, std::function<void(T*)>>;
     template<typename F, typename... Args>
-    auto get(F&& f, Args&&... args) const->tracked_ptr {
-        T* t = nullptr;
-        if (!pool_.pop(&t)) {
-            printf("LIFO pool is empty. create a new one\n");
+    handle get(F&& f, Args&&... args) const {
+        T* t = take();
+        if (!t) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
             t = f(std::forward<Args>(args)...);
         }
         assert(t && "t can't be null");
-        return {t, [this](T* t){
-                pool_.push(std::move(t));
-            }};
+        return {t, this, -1};
     }
 
     // try to get from static pool, and fallback to get() using lock free lifo
     template<typename F, typename... Args>
-    auto get2(F&& f, Args&&... args) const->std::unique_ptr<T, std::function<void(T*)>> {
-        for (auto& p : fixed_pool_) {
-            if (!p.used.test_and_set()) {
-                if (!p.v) // safe to check and init because only 1 thread can use it
-                    p.v = f(std::forward<Args>(args)...);
-                return {p.v, [&p](T* t){ p.used.clear();}};
+    handle get2(F&& f, Args&&... args) const {
+        int& hint = fixed_hint();
+        for (int k = 0; k < fixed_words; ++k) {
+            const int w = (hint + k) % fixed_words;
+            uint64_t bits = used_[w].load(std::memory_order_relaxed);
+            while (~bits) {
+                const int i = w*64 + first_zero(bits);
+                const uint64_t bit = 1ULL << (i % 64);
+                bits = used_[w].fetch_or(bit, std::memory_order_acquire);
+                if (bits & bit) // claimed by another thread
+                    continue;
+                hint = w;
+                if (!fixed_pool_[i]) // safe to check and init because only 1 thread can use it
+                    fixed_pool_[i] = f(std::forward<Args>(args)...);
+                return {fixed_pool_[i], this, i};
             }
         }
         return get(std::forward<F>(f), std::forward<Args>(args)...);
     }
+
+    // number of objects created by get() because pool is empty
+    uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
 private:
-    mutable C<T*> pool_;
-    using fixed_pool_node = struct {
-        T* v = nullptr;
-        std::atomic_flag used = ATOMIC_FLAG_INIT;
+    struct magazine {
+        int count = 0;
+        T* items[MagazineSize];
+    };
+
+    // magazines of a thread. owned by the pool and the thread. active is false if the thread exited, or true if claimed by reclaim()
+    struct local {
+        magazine* loaded = nullptr;
+        magazine* spare = nullptr;
+        std::atomic<bool> active = {true};
+        std::atomic<int> refs = {2};
+        local* next = nullptr;
+
+        void release() {
+            if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete this;
+        }
+        void orphan() {
+            active.store(false, std::memory_order_release); // magazines can be reclaimed
+            release();
+        }
+    };
+
+    // per thread, for all pools of this type
+    struct registry {
+        std::vector<std::pair<uint64_t, local*>> locals;
+
+        ~registry() {
+            for (auto& l : locals)
+                l.second->orphan();
+        }
+        static registry& instance() {
+            thread_local registry r;
+            return r;
+        }
     };
-    mutable fixed_pool_node fixed_pool_[PoolSize];
+
+    // never reused, so a destroyed pool's local in registry will not be found by a new pool at the same address
+    static uint64_t next_id() {
+        static std::atomic<uint64_t> id{0};
+        return id.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    local* find_local() const {
+        for (auto& l : registry::instance().locals) {
+            if (l.first == id_)
+                return l.second;
+        }
+        return nullptr;
+    }
+
+    local& this_local() const {
+        if (local* l = find_local())
+            return *l;
+        auto& locals = registry::instance().locals;
+        for (auto it = locals.begin(); it != locals.end();) { // pool is destroyed if refs is 1
+            if (it->second->refs.load(std::memory_order_acquire) == 1) {
+                it->second->orphan();
+                it = locals.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        local* l = locals_.load(std::memory_order_acquire);
+        for (; l; l = l->next) { // adopt magazines of an exited thread
+            bool active = false;
+            if (!l->active.load(std::memory_order_relaxed) && l->active.compare_exchange_strong(active, true, std::memory_order_acquire)) {
+                l->refs.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+        if (!l) {
+            l = new local();
+            l->next = locals_.load(std::memory_order_relaxed);
+            while (!locals_.compare_exchange_weak(l->next, l, std::memory_order_release, std::memory_order_relaxed)) {}
+        }
+        locals.emplace_back(id_, l);
+        return *l;
+    }
+
+    // return true if a non-empty magazine is moved to full_
+    bool flush(local& l) const {
+        const bool moved = (l.loaded && l.loaded->count > 0) || (l.spare && l.spare->count > 0);
+        for (magazine* m : {l.loaded, l.spare}) {
+            if (!m)
+                continue;
+            if (m->count > 0)
+                full_.push(m);
+            else
+                empty_.push(m);
+        }
+        l.loaded = l.spare = nullptr;
+        return moved;
+    }
+
+    // move magazines of exited threads to full_
+    bool reclaim() const {
+        bool moved = false;
+        for (local* l = locals_.load(std::memory_order_acquire); l; l = l->next) {
+            bool active = false;
+            if (l->active.load(std::memory_order_relaxed) || !l->active.compare_exchange_strong(active, true, std::memory_order_acquire))
+                continue;
+            moved |= flush(*l);
+            l->active.store(false, std::memory_order_release);
+        }
+        return moved;
+    }
+
+    static int first_zero(uint64_t bits) {
+#if defined(_MSC_VER)
+        unsigned long r = 0;
+        _BitScanForward64(&r, ~bits);
+        return (int)r;
+#else
+        return __builtin_ctzll(~bits);
+#endif
+    }
+
+    // threads start from different words
+    static int& fixed_hint() {
+        static std::atomic<int> next{0};
+        thread_local int hint = -1; // constant initialized, no tls guard
+        if (hint < 0)
+            hint = next.fetch_add(1, std::memory_order_relaxed) % fixed_words;
+        return hint;
+    }
+
+    void recycle(T* t, int slot) const {
+        if (slot >= 0)
+            used_[slot/64].fetch_and(~(1ULL << (slot % 64)), std::memory_order_release);
+        else
+            put(t);
+    }
+
+    // return null if pool is empty
+    T* take() const {
+        local& l = this_local();
+        if (!l.loaded || l.loaded->count == 0) {
+            if (l.spare && l.spare->count > 0) {
+                std::swap(l.loaded, l.spare);
+            } else {
+                magazine* m = nullptr;
+                if (!full_.pop(&m) && !(reclaim() && full_.pop(&m)))
+                    return nullptr;
+                if (l.loaded) {
+                    if (!l.spare)
+                        l.spare = l.loaded;
+                    else
+                        empty_.push(l.loaded);
+                }
+                l.loaded = m;
+            }
+        }
+        return l.loaded->items[--l.loaded->count];
+    }
+
+    void put(T* t) const {
+        local& l = this_local();
+        if (!l.loaded || l.loaded->count == MagazineSize) {
+            if (l.spare && l.spare->count < MagazineSize) {
+                std::swap(l.loaded, l.spare);
+            } else {
+                if (l.spare) // full
+                    full_.push(l.spare);
+                l.spare = l.loaded;
+                l.loaded = nullptr;
+                if (!empty_.pop(&l.loaded))
+                    l.loaded = new magazine();
+            }
+        }
+        l.loaded->items[l.loaded->count++] = t;
+    }
+
+    const uint64_t id_;
+    mutable C<magazine*> full_; // not empty magazines
+    mutable C<magazine*> empty_;
+    mutable std::atomic<local*> locals_ = {nullptr}; // only grows, like hazard pointer records
+    mutable std::atomic<uint64_t> misses_ = {0};
+    static constexpr int fixed_words = (PoolSize + 63)/64;
+    mutable std::atomic<uint64_t> used_[fixed_words]; // bit i is set if fixed_pool_[i] is in use
+    mutable T* fixed_pool_[PoolSize] = {};
     std::function<void(T*)> deleter_ = std::default_delete<T>();
 };
 
@@ -87,4 +351,4 @@ template<typename T, int N=16>
 using mpmc_pool = pool<T, mpmc_lifo, N>;
 
 template<typename T, int N=16>
-using mpsc_pool = pool<T, mpmc_lifo, N>;
\ No newline at end of file
+using mpsc_pool = pool<T, mpmc_lifo, N>;
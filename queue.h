@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2026 WangBin <wbsecg1 at gmail.com>
+ * MIT License
+ * Queue Selected by Producer/Consumer Count
+ * https://github.com/wang-bin/lockless
+ */
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include "spsc_fifo.h"
+#include "spsc_bounded_fifo.h"
+#include "mpsc_fifo.h"
+#include "mpmc_fifo.h"
+#include "mpmc_bounded_fifo.h"
+#include "stats.h"
+#if defined(__cpp_concepts) && __cpp_concepts >= 201907L
+#include <concepts>
+#endif
+
+// one api for all fifos, the cheapest implementation for the number of producers and consumers is selected at compile time:
+//   unbounded: spsc_fifo, mpsc_fifo, mpmc_fifo. bounded(capacity is passed to ctor): spsc_bounded_fifo, mpmc_bounded_fifo
+// e.g. lockless::queue<T, lockless::one, lockless::many> q; q.try_push(v); q.try_pop(&v);
+// unbounded queues count size by Stats. with null_stats(default), size_stats is used instead, so size_approx() is always available
+namespace lockless {
+
+constexpr int one = 1;
+constexpr int many = 2; // any value > 1
+
+template<typename T, int Producers = many, int Consumers = many, bool Bounded = false, class Stats = null_stats>
+class queue {
+    static constexpr bool single_producer = Producers <= one;
+    static constexpr bool single_consumer = Consumers <= one;
+    using counting_stats = std::conditional_t<!Bounded && std::is_same<Stats, null_stats>::value, size_stats<>, Stats>;
+public:
+    using value_type = T;
+    using type = std::conditional_t<Bounded,
+        std::conditional_t<single_producer && single_consumer, spsc_bounded_fifo<T, Stats>, mpmc_bounded_fifo<T, Stats>>,
+        std::conditional_t<single_consumer,
+            std::conditional_t<single_producer, spsc_fifo<T, counting_stats>, mpsc_fifo<T, counting_stats>>,
+            mpmc_fifo<T, counting_stats>>>;
+
+    // bounded queues require capacity
+    template<typename... Args>
+    explicit queue(Args&&... args) : q_(std::forward<Args>(args)...) {}
+
+    // return false if full. unbounded queues always return true
+    template<typename U>
+    bool try_push(U&& v) {
+        if constexpr (Bounded) {
+            return q_.try_push(std::forward<U>(v));
+        } else {
+            q_.push(std::forward<U>(v));
+            return true;
+        }
+    }
+
+    // return false if full. unbounded queues always return true
+    template<typename... Args>
+    bool emplace(Args&&... args) {
+        if constexpr (Bounded) {
+            return q_.try_emplace(std::forward<Args>(args)...);
+        } else {
+            q_.emplace(std::forward<Args>(args)...);
+            return true;
+        }
+    }
+
+    // return false if empty
+    bool try_pop(T* v = nullptr) {
+        if constexpr (Bounded)
+            return q_.try_pop(v);
+        else
+            return q_.pop(v);
+    }
+
+    // approximate if producers or consumers are running
+    size_t size_approx() const {
+        if constexpr (Bounded) {
+            return q_.size();
+        } else {
+            const auto n = q_.stats().size;
+            return n > 0 ? size_t(n) : 0;
+        }
+    }
+
+    // return number of element cleared, in consumer thread
+    int clear() { return q_.clear(); }
+
+    queue_stats stats() const { return q_.stats(); }
+
+    type& get() { return q_; }
+    const type& get() const { return q_; }
+private:
+    type q_;
+};
+
+template<typename T, class Stats = null_stats>
+using spsc_queue = queue<T, one, one, false, Stats>;
+template<typename T, class Stats = null_stats>
+using mpsc_queue = queue<T, many, one, false, Stats>;
+template<typename T, class Stats = null_stats>
+using mpmc_queue = queue<T, many, many, false, Stats>;
+template<typename T, int Producers = many, int Consumers = many, class Stats = null_stats>
+using bounded_queue = queue<T, Producers, Consumers, true, Stats>;
+
+#if defined(__cpp_concepts) && __cpp_concepts >= 201907L
+// the api of queue, for generic code taking any queue
+template<typename Q>
+concept concurrent_queue = requires(Q q, const Q cq, typename Q::value_type v, typename Q::value_type* p) {
+    { q.try_push(v) } -> std::same_as<bool>;
+    { q.try_push(std::move(v)) } -> std::same_as<bool>;
+    { q.try_pop(p) } -> std::same_as<bool>;
+    { q.emplace(v) } -> std::same_as<bool>;
+    { cq.size_approx() } -> std::convertible_to<size_t>;
+};
+
+static_assert(concurrent_queue<queue<int>>);
+static_assert(concurrent_queue<mpmc_queue<int, sharded_stats<>>>);
+static_assert(concurrent_queue<bounded_queue<int, one, one>>);
+#endif
+} // namespace lockless
@@ -20,33 +20,76 @@
 ******************************************************************************/
 
 #pragma once
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <iterator>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
 #include <vector>
-#include <iostream>
 #include <mutex>
+#include <type_traits>
 #include "null_mutex.h"
 //https://github.com/WG21-SG14/SG14/tree/master/Docs/Proposals
 //https://github.com/WG21-SG14/SG14/blob/master/SG14/ring.h
 
-template<typename T, typename C, class Mutex>
-class ring_api : private Mutex {
+namespace lockless {
+// what push does if ring is full
+enum class overflow {
+    overwrite, // drop the oldest value
+    reject, // drop the new value, push returns false
+    block, // wait until a value is popped. Mutex must be a real mutex
+};
+
+// state for overflow::block only, empty base for other policies. so a non-blocking ring has no condition variable, and is copyable like before
+template<overflow Policy>
+struct overflow_wait {};
+
+template<>
+struct overflow_wait<overflow::block> {
+    std::condition_variable_any not_full_;
+};
+} // namespace lockless
+
+template<typename T, typename C, class Mutex, lockless::overflow Policy = lockless::overflow::overwrite>
+class ring_api : private Mutex, private lockless::overflow_wait<Policy> {
+    static_assert(Policy != lockless::overflow::block || !std::is_same<Mutex, null_mutex>::value, "overflow::block requires a mutex");
 public:
     void clear() { while (pop_front()) {}}
 
+    // return false if rejected because ring is full
+    template<typename U>
+    bool push(U&& t) {
+        std::unique_lock<Mutex> lock(*this); // std::unique_lock will be unique_lock<ring_api> and is not a unique_lock<Mutex> because of private inheritance
+        if (!make_room<Policy>(lock))
+            return false;
+        data_[in_] = std::forward<U>(t);
+        in_ = index(in_+1);
+        return true;
+    }
+
+    // never overwrites or blocks, return false if full
     template<typename U>
-    void push(U&& t) {
-        std::lock_guard<Mutex> lock(*this); // std::lock_guard will be lock_guard<ring_api> and is not a lock_guard<Mutex> because of private inheritance
+    bool try_push(U&& t) {
+        std::unique_lock<Mutex> lock(*this);
+        if (!make_room<lockless::overflow::reject>(lock))
+            return false;
         data_[in_] = std::forward<U>(t);
-        update_index_after_push();
+        in_ = index(in_+1);
+        return true;
     }
 
     template<typename... Args>
-    void emplace(Args&&... args) {
-        std::lock_guard<Mutex> lock(*this);
+    bool emplace(Args&&... args) {
+        std::unique_lock<Mutex> lock(*this);
+        if (!make_room<Policy>(lock))
+            return false;
         //static_assert(std::is_array<C>::value, "only static_ring supports emplace(...)");
         data_[in_].~T(); // already default constructed, so destruct first
         new (&data_[in_]) T{std::forward<Args>(args)...};
-        update_index_after_push();
+        in_ = index(in_+1);
+        return true;
     }
 
 // stl compatible
@@ -68,17 +111,128 @@ public:
         //if (!std::is_array<C>::value)
           //  new (&data_[out_]) T();
         out_ = index(out_+1);
+        if constexpr (Policy == lockless::overflow::block)
+            this->not_full_.notify_one();
         return n;
     }
     bool pop_front() { return pop() > 0; }
 
+    // a slot accessed in place by claim() or front_claim(), e.g. a large video frame. the ring mutex is held as long as the slot,
+    // so every other push, pop, claim and front_claim blocks until the slot is destroyed. keep it short.
+    // destroying the slot publishes the value of claim(), or pops the value of front_claim(), but not if destroyed by an exception
+    template<bool Producer>
+    class slot {
+    public:
+        slot(slot&& o) noexcept : r_(o.r_), v_(o.v_), exceptions_(o.exceptions_) { o.r_ = nullptr; }
+        slot& operator=(const slot&) = delete;
+        ~slot() {
+            if (!r_)
+                return;
+            if (v_ && std::uncaught_exceptions() <= exceptions_) {
+                if constexpr (Producer)
+                    r_->in_ = r_->index(r_->in_+1);
+                else
+                    r_->pop_unlocked();
+            }
+            r_->mutex().unlock();
+        }
+
+        explicit operator bool() const { return !!v_; }
+        T* get() const { return v_; }
+        T& operator*() const { return *v_; }
+        T* operator->() const { return v_; }
+    private:
+        friend class ring_api;
+        slot(ring_api* r, T* v) : r_(r), v_(v), exceptions_(std::uncaught_exceptions()) {}
+
+        ring_api* r_; // locked by this slot if not null
+        T* v_;
+        int exceptions_;
+    };
+
+    // producer: construct a value in a free slot, published when the slot is destroyed. the slot is empty if rejected by overflow::reject
+    template<typename... Args>
+    slot<true> claim(Args&&... args) {
+        std::unique_lock<Mutex> lock(*this);
+        if (!make_room<Policy>(lock))
+            return slot<true>(nullptr, nullptr);
+        data_[in_].~T(); // already default constructed, so destruct first
+        T* v = new (&data_[in_]) T{std::forward<Args>(args)...};
+        lock.release(); // unlocked by slot
+        return slot<true>(this, v);
+    }
+
+    // consumer: the first value in place, popped when the slot is destroyed. the slot is empty if ring is empty
+    slot<false> front_claim() {
+        std::unique_lock<Mutex> lock(*this);
+        if (size() == 0)
+            return slot<false>(nullptr, nullptr);
+        lock.release(); // unlocked by slot
+        return slot<false>(this, &data_[out_]);
+    }
+
+    // bulk write in 1 lock, wrap-around is at most 2 contiguous segments. if no enough space,
+    // overwrite: the oldest values are overwritten, and only the last capacity() values are stored if n > capacity()
+    // reject: values not fit are dropped
+    // block: wait and write until all values are written
+    // return number of values stored
+    size_t write(const T* v, size_t n) {
+        std::unique_lock<Mutex> lock(*this);
+        if constexpr (Policy == lockless::overflow::overwrite) {
+            if (n > capacity()) {
+                overwrites_ += n - capacity();
+                v += n - capacity();
+                n = capacity();
+            }
+            const size_t s = size();
+            if (s + n > capacity()) {
+                overwrites_ += s + n - capacity();
+                out_ = index(out_ + s + n - capacity());
+            }
+            write_unlocked(v, n);
+            return n;
+        } else if constexpr (Policy == lockless::overflow::reject) {
+            const size_t m = std::min(n, capacity() - size());
+            if (m < n)
+                rejects_ += n - m;
+            write_unlocked(v, m);
+            return m;
+        } else {
+            for (size_t done = 0; done < n;) {
+                this->not_full_.wait(lock, [this]{ return size() < capacity(); });
+                const size_t m = std::min(n - done, capacity() - size());
+                write_unlocked(v + done, m);
+                done += m;
+            }
+            return n;
+        }
+    }
+
+    // bulk read at most n values. return number of values read
+    size_t read(T* v, size_t n) {
+        std::lock_guard<Mutex> lock(*this);
+        n = peek_unlocked(v, n);
+        out_ = index(out_ + n);
+        if constexpr (Policy == lockless::overflow::block) {
+            if (n > 0)
+                this->not_full_.notify_all();
+        }
+        return n;
+    }
+
+    // copy at most n values from front without removing them. return number of values copied
+    size_t peek(T* v, size_t n) {
+        std::lock_guard<Mutex> lock(*this);
+        return peek_unlocked(v, n);
+    }
+
     T &front() {
         //std::lock_guard<Mutex> lock(*this);
         return data_[out_];
     }
 
     const T &front() const {
-        std::lock_guard<Mutex> lock(*this);
+        std::lock_guard<Mutex> lock(mutex());
         return data_[out_];
     }
     T &back() {
@@ -87,7 +241,7 @@ public:
     }
 
     const T &back() const {
-        std::lock_guard<Mutex> lock(*this);
+        std::lock_guard<Mutex> lock(mutex());
         return data_[in_];
     }
     size_t capacity() const { return std::size(data_) - 1; }
@@ -97,7 +251,7 @@ public:
     bool empty() const { return size() == 0;}
     // need at() []?
     const T &at(size_t i) const {
-        std::lock_guard<Mutex> lock(*this);
+        std::lock_guard<Mutex> lock(mutex());
         return data_[index(out_+i)];
     }
 
@@ -115,15 +269,69 @@ public:
 
     size_t index_in() const {return in_;}
     size_t index_out() const {return out_;}
+
+    // number of old values dropped by overflow::overwrite
+    size_t overwrites() const {
+        std::lock_guard<Mutex> lock(mutex());
+        return overwrites_;
+    }
+    // number of new values dropped by overflow::reject or try_push()
+    size_t rejects() const {
+        std::lock_guard<Mutex> lock(mutex());
+        return rejects_;
+    }
 protected:
+    Mutex& mutex() const { return const_cast<ring_api&>(*this); } // lock in const functions
     size_t extent() const { return capacity() + 1; }
     size_t index(size_t i) const { return i < extent() ? i : i - extent();} // i is always in [0,extent())
-    void update_index_after_push() {
-        if (size() == capacity()) {
-            std::clog << capacity() << " overwrite queued data. in " << in_ << " out_ " << out_ << std::endl;
+
+    // memcpy for trivially copyable T
+    static void copy(T* dst, const T* src, size_t n) {
+        if constexpr (std::is_trivially_copyable<T>::value) {
+            if (n > 0)
+                memcpy(dst, src, n*sizeof(T));
+        } else {
+            std::copy(src, src + n, dst);
+        }
+    }
+
+    void pop_unlocked() {
+        out_ = index(out_+1);
+        if constexpr (Policy == lockless::overflow::block)
+            this->not_full_.notify_one();
+    }
+
+    size_t peek_unlocked(T* v, size_t n) const {
+        n = std::min(n, size());
+        const size_t n1 = std::min(n, extent() - out_);
+        copy(v, &data_[out_], n1);
+        copy(v + n1, &data_[0], n - n1);
+        return n;
+    }
+    // make room for 1 value if full. return false if rejected
+    template<lockless::overflow P, class Lock>
+    bool make_room(Lock& lock) {
+        if (size() < capacity())
+            return true;
+        if constexpr (P == lockless::overflow::overwrite) {
+            overwrites_++;
             out_ = index(out_+1);
+            return true;
+        } else if constexpr (P == lockless::overflow::reject) {
+            rejects_++;
+            return false;
+        } else {
+            this->not_full_.wait(lock, [this]{ return size() < capacity(); });
+            return true;
         }
-        in_ = index(in_+1);
+    }
+
+    // n <= free space
+    void write_unlocked(const T* v, size_t n) {
+        const size_t n1 = std::min(n, extent() - in_);
+        copy(&data_[in_], v, n1);
+        copy(&data_[0], v + n1, n - n1);
+        in_ = index(in_ + n);
     }
 
 //  [1, 2, ..., cap, extent]
@@ -131,13 +339,15 @@ protected:
     size_t in_ = 0;
     C data_;
     Mutex mtx_;
+    size_t overwrites_ = 0; // under lock
+    size_t rejects_ = 0;
 };
 
-template<typename T, class Mutex = null_mutex>
-class ring : public ring_api<T, std::vector<T>, Mutex> {
-    using api = ring_api<T, std::vector<T>, Mutex>;
+template<typename T, class Mutex = null_mutex, lockless::overflow Policy = lockless::overflow::overwrite>
+class ring : public ring_api<T, std::vector<T>, Mutex, Policy> {
+    using api = ring_api<T, std::vector<T>, Mutex, Policy>;
     using api::data_; // why need this?
-    // store data here, construct ring_api with data begin/end like ring_span, data must be contiguous
+    // store data here. see ring_span for data owned by caller
 public:
     ring(size_t cap = 0) : api() {
         reserve(cap);
@@ -160,9 +370,9 @@ public:
     }
 };
 
-template<typename T, int N, class Mutex = null_mutex>
-class static_ring : public ring_api<T, T[N+1], Mutex> {
-    using api = ring_api<T, T[N+1], Mutex>;
+template<typename T, int N, class Mutex = null_mutex, lockless::overflow Policy = lockless::overflow::overwrite>
+class static_ring : public ring_api<T, T[N+1], Mutex, Policy> {
+    using api = ring_api<T, T[N+1], Mutex, Policy>;
     using api::data_; // why need this?
 public:
     static_ring() : api() {}
@@ -178,3 +388,43 @@ public:
             api::pop();
     }
 };
+
+namespace lockless {
+// contiguous memory owned by caller, used as ring_api container
+template<typename T>
+class span_data {
+public:
+    span_data() = default;
+    span_data(T* data, size_t count) : data_(data), count_(count) {}
+
+    size_t size() const { return count_; }
+    T& operator[](size_t i) { return data_[i]; }
+    const T& operator[](size_t i) const { return data_[i]; }
+    T* begin() const { return data_; }
+    T* end() const { return data_ + count_; }
+private:
+    T* data_ = nullptr;
+    size_t count_ = 0;
+};
+} // namespace lockless
+
+// ring in caller provided memory, e.g. a dma buffer, hugepages or a member of a larger struct. no allocation(except the condition variable of overflow::block)
+// memory of count objects must be constructed(or T is trivial) and outlive the ring. capacity() is count - 1
+template<typename T, class Mutex = null_mutex, lockless::overflow Policy = lockless::overflow::overwrite>
+class ring_span : public ring_api<T, lockless::span_data<T>, Mutex, Policy> {
+    using api = ring_api<T, lockless::span_data<T>, Mutex, Policy>;
+    using api::data_;
+public:
+    ring_span(T* data, size_t count) : api() {
+        assert(count > 0 && "1 object is reserved to distinguish full and empty");
+        data_ = lockless::span_data<T>(data, count);
+    }
+    ring_span(T* begin, T* end) : ring_span(begin, size_t(end - begin)) {}
+    template<size_t N>
+    ring_span(T (&data)[N]) : ring_span(data, N) {}
+
+    ring_span(const ring_span&) = delete;
+    ring_span& operator=(const ring_span&) = delete;
+
+    T* data() const { return data_.begin(); }
+};
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2026 WangBin <wbsecg1 at gmail.com>
+ * MIT License
+ * Lock Free Sharded MPMC FIFO
+ * https://github.com/wang-bin/lockless
+ */
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <utility>
+#include "cacheline.h"
+#include "mpmc_fifo.h"
+#include "stats.h"
+
+// mpmc_fifo serializes all producers on in_ and all consumers on out_. here producers and consumers are spread over shards(mpmc_fifo) by thread:
+// a producer always pushes to its home shard, a consumer pops its home shard first, then steals from other shards round-robin.
+// values are FIFO per shard only: values of 1 producer are popped in push order, but values of different producers(shards) are not globally ordered
+namespace lockless {
+
+template<typename T, class Stats = null_stats>
+class sharded_fifo {
+public:
+    // shards <= 0: number of hardware threads
+    explicit sharded_fifo(int shards = 0)
+        : count_(shards > 0 ? shards : std::max(1, (int)std::thread::hardware_concurrency()))
+        , shards_(new shard[count_])
+    {}
+
+    // return number of element cleared
+    int clear() {
+        int n = 0;
+        for (int i = 0; i < count_; ++i)
+            n += shards_[i].q.clear();
+        return n;
+    }
+
+    template<typename... Args>
+    void emplace(Args&&... args) {
+        shards_[home<producer>()].q.emplace(std::forward<Args>(args)...);
+    }
+
+    template<typename U>
+    void push(U&& v) {
+        shards_[home<producer>()].q.push(std::forward<U>(v));
+    }
+
+    // return false if all shards are empty
+    bool pop(T* v = nullptr) {
+        const int h = home<consumer>();
+        for (int k = 0; k < count_; ++k) {
+            int i = h + k;
+            if (i >= count_)
+                i -= count_;
+            if (shards_[i].q.pop(v))
+                return true;
+        }
+        return false;
+    }
+
+    int shards() const { return count_; }
+
+    queue_stats stats() const {
+        queue_stats st;
+        for (int i = 0; i < count_; ++i) {
+            const auto s = shards_[i].q.stats();
+            st.pushes += s.pushes;
+            st.pops += s.pops;
+            st.failed_pops += s.failed_pops;
+            st.cas_retries += s.cas_retries;
+            st.size += s.size;
+            st.peak_size = std::max(st.peak_size, s.peak_size);
+        }
+        return st;
+    }
+private:
+    struct alignas(cacheline_size) shard {
+        mpmc_fifo<T, Stats> q;
+    };
+
+    enum role { producer, consumer };
+
+    // producer and consumer threads are numbered separately in first use order, so n producers use n different shards if n <= shards, and so do consumers
+    template<role R>
+    int home() const {
+        static std::atomic<int> next = {0};
+        thread_local const int id = next.fetch_add(1, std::memory_order_relaxed);
+        return id % count_;
+    }
+
+    const int count_;
+    const std::unique_ptr<shard[]> shards_;
+};
+} // namespace lockless
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2026 WangBin <wbsecg1 at gmail.com>
+ * MIT License
+ * Lock Free Inter-Process SPSC/MPSC FIFO
+ * https://github.com/wang-bin/lockless
+ */
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "cacheline.h"
+
+// the whole queue lives in a shared memory region(shm_open), so processes can attach by name and pass values without copy to kernel.
+// region: header{magic, version, layout, indices} + nodes[capacity + 1]. nodes are linked by index instead of pointer, so the region can be mapped at any address.
+// unused nodes are in a free stack of {index, tag}(like mpmc_tagged_lifo), producers pop from it, consumer pushes to it. push returns false if no free node.
+// indices are lock free and address free atomics, so the same memory order as mpsc_fifo/spsc_fifo works across processes.
+// no blocking wait, eventcount uses a process private futex. T must be trivially copyable, e.g. no pointer to process memory
+namespace lockless {
+
+template<typename T, bool MultiProducer>
+class shm_fifo_api {
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free, "atomics in shared memory must be lock free");
+public:
+    static constexpr uint32_t version = 1;
+
+    // create region name(e.g. "/my_queue") of capacity values. the name is unlinked when destroyed
+    shm_fifo_api(const char* name, uint32_t capacity) : name_(name), owner_(true) {
+        const int fd = shm_open(name, O_RDWR|O_CREAT|O_EXCL, 0600);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), "shm_fifo create");
+        size_ = region_size(capacity);
+        if (ftruncate(fd, off_t(size_)) != 0) {
+            const int e = errno;
+            shm_unlink(name);
+            fail(fd, e, "shm_fifo ftruncate");
+        }
+        map(fd);
+        init(capacity);
+    }
+
+    // attach to region name created by another process
+    explicit shm_fifo_api(const char* name) : name_(name) {
+        const int fd = shm_open(name, O_RDWR, 0);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), "shm_fifo attach");
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+            fail(fd, errno, "shm_fifo stat");
+        size_ = size_t(st.st_size);
+        if (size_ < sizeof(header)) // creator has not called ftruncate
+            fail(fd, EAGAIN, "shm_fifo attach");
+        map(fd);
+        const header& h = *h_;
+        if (h.ready.load(std::memory_order_acquire) != 1) {
+            munmap(h_, size_);
+            throw std::system_error(EAGAIN, std::generic_category(), "shm_fifo not ready");
+        }
+        if (h.magic != magic || h.version != version || h.value_size != sizeof(T) || h.value_align != alignof(T)
+            || h.multi_producer != MultiProducer || size_ < region_size(h.capacity)) {
+            munmap(h_, size_);
+            throw std::system_error(EPROTO, std::generic_category(), "shm_fifo layout mismatch");
+        }
+    }
+
+    ~shm_fifo_api() {
+        munmap(h_, size_);
+        if (owner_)
+            shm_unlink(name_.c_str());
+    }
+
+    shm_fifo_api(const shm_fifo_api&) = delete;
+    shm_fifo_api& operator=(const shm_fifo_api&) = delete;
+
+    // return number of element cleared
+    int clear() {
+        int n = 0;
+        while (pop())
+            n++;
+        return n;
+    } // in consumer
+
+    // return false if full
+    template<typename... Args>
+    bool emplace(Args&&... args) {
+        return push(T{std::forward<Args>(args)...});
+    }
+
+    // return false if full
+    bool push(const T& v) {
+        const uint32_t i = pop_free();
+        if (i == null_index)
+            return false;
+        node* n = at(i);
+        memcpy(n->storage, &v, sizeof(T));
+        n->next.store(null_index, std::memory_order_relaxed);
+        uint32_t t = 0;
+        if constexpr (MultiProducer) {
+            t = h_->in.exchange(i, std::memory_order_acq_rel);
+        } else {
+            t = h_->in.load(std::memory_order_relaxed);
+            h_->in.store(i, std::memory_order_relaxed);
+        }
+        at(t)->next.store(i, std::memory_order_release); // publish value
+        return true;
+    }
+
+    bool pop(T* v = nullptr) {
+        const uint32_t o = h_->out.load(std::memory_order_relaxed);
+        const uint32_t n = at(o)->next.load(std::memory_order_acquire);
+        if (n == null_index) // empty, or before t->next.store() in push()
+            return false;
+        if (v)
+            memcpy(v, at(n)->storage, sizeof(T));
+        h_->out.store(n, std::memory_order_relaxed);
+        push_free(o); // n is the new dummy node
+        return true;
+    }
+
+    bool empty() const { return at(h_->out.load(std::memory_order_relaxed))->next.load(std::memory_order_acquire) == null_index; }
+    uint32_t capacity() const { return h_->capacity; }
+    const std::string& name() const { return name_; }
+private:
+    static constexpr uint64_t magic = 0x6f6669666d68736cULL; // "lshmfifo"
+    static constexpr uint32_t null_index = UINT32_MAX;
+
+    struct header {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t value_size;
+        uint32_t value_align;
+        uint32_t multi_producer;
+        uint32_t capacity;
+        std::atomic<uint32_t> ready; // set after nodes are initialized
+        alignas(cacheline_size) std::atomic<uint32_t> in; // last node, producers
+        alignas(cacheline_size) std::atomic<uint32_t> out; // dummy node, consumer
+        alignas(cacheline_size) std::atomic<uint64_t> free; // {index, tag} of free stack top
+    };
+
+    struct node {
+        std::atomic<uint32_t> next; // next in fifo or free stack
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    static size_t region_size(uint32_t capacity) { return sizeof(header) + sizeof(node)*(size_t(capacity) + 1); }
+
+    static uint64_t pack(uint32_t index, uint32_t tag) { return (uint64_t(tag) << 32) | index; }
+    static uint32_t index_of(uint64_t head) { return uint32_t(head); }
+    static uint32_t tag_of(uint64_t head) { return uint32_t(head >> 32); }
+
+    [[noreturn]] static void fail(int fd, int e, const char* what) {
+        close(fd);
+        throw std::system_error(e, std::generic_category(), what);
+    }
+
+    void map(int fd) {
+        void* p = mmap(nullptr, size_, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            const int e = errno;
+            if (owner_)
+                shm_unlink(name_.c_str());
+            fail(fd, e, "shm_fifo map");
+        }
+        close(fd); // mapping keeps the object
+        h_ = static_cast<header*>(p);
+        nodes_ = reinterpret_cast<node*>(h_ + 1);
+    }
+
+    // node 0 is the dummy node, others are free
+    void init(uint32_t capacity) {
+        header* h = new (h_) header{magic, version, uint32_t(sizeof(T)), uint32_t(alignof(T)), MultiProducer, capacity, {0}, {0}, {0}, {pack(capacity ? 1 : null_index, 0)}};
+        for (uint32_t i = 0; i <= capacity; ++i)
+            new (&nodes_[i]) node{{i == 0 || i == capacity ? null_index : i + 1}, {}};
+        h->ready.store(1, std::memory_order_release);
+    }
+
+    node* at(uint32_t i) const { return nodes_ + i; }
+
+    // a stale pop may read next of a reused node, it's harmless because the CAS will fail
+    uint32_t pop_free() {
+        uint64_t h = h_->free.load(std::memory_order_acquire);
+        for (;;) {
+            const uint32_t i = index_of(h);
+            if (i == null_index)
+                return i;
+            const uint32_t next = at(i)->next.load(std::memory_order_relaxed);
+            if (h_->free.compare_exchange_weak(h, pack(next, tag_of(h) + 1), std::memory_order_acquire, std::memory_order_acquire))
+                return i;
+        }
+    }
+
+    void push_free(uint32_t i) {
+        node* n = at(i);
+        uint64_t h = h_->free.load(std::memory_order_relaxed);
+        do {
+            n->next.store(index_of(h), std::memory_order_relaxed);
+        } while (!h_->free.compare_exchange_weak(h, pack(i, tag_of(h) + 1), std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    std::string name_;
+    bool owner_ = false;
+    size_t size_ = 0;
+    header* h_ = nullptr;
+    node* nodes_ = nullptr;
+};
+
+template<typename T>
+using shm_spsc_fifo = shm_fifo_api<T, false>;
+template<typename T>
+using shm_mpsc_fifo = shm_fifo_api<T, true>;
+} // namespace lockless
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2026 WangBin <wbsecg1 at gmail.com>
+ * MIT License
+ * Lock Free Slab Allocator
+ * https://github.com/wang-bin/lockless
+ */
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+// blocks of size classes(16, 32, ..., 256 bytes) are carved from chunks, and recycled by thread local free lists.
+// a thread gives batch_size blocks to a global lock free depot if it has too many free blocks(e.g. consumer frees nodes pushed by producer),
+// and takes all batches from depot if it has none. so the global heap is used only to grow chunks, which are never returned until exit.
+// depot is popped by exchange(all batches), so no ABA and no list walk. other sizes and alignments use ::operator new/delete
+namespace lockless {
+
+class slab_arena {
+public:
+    static constexpr size_t granularity = 16;
+    static constexpr size_t max_size = 256;
+    static constexpr int classes = max_size/granularity;
+    static constexpr int batch_size = 64;
+    static constexpr size_t chunk_size = 64*1024;
+
+    // never destroyed, static objects destroyed later may still deallocate
+    static slab_arena& instance() {
+        static slab_arena* a = new slab_arena();
+        return *a;
+    }
+
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        if (size == 0 || size > max_size || align > granularity)
+            return heap_allocate(size, align);
+        const int c = size_class(size);
+        thread_state& t = local();
+        if (t.exited) { // e.g. called by destructors of other thread_local objects
+            cache fl;
+            refill(c, fl);
+            block* b = fl.head;
+            fl.head = b->next;
+            give_back(c, fl);
+            return b;
+        }
+        cache& fl = t.lists[c];
+        if (!fl.head)
+            refill(c, fl);
+        block* b = fl.head;
+        fl.head = b->next;
+        fl.count--;
+        return b;
+    }
+
+    void deallocate(void* p, size_t size, size_t align = alignof(std::max_align_t)) {
+        if (size == 0 || size > max_size || align > granularity) {
+            heap_deallocate(p, align);
+            return;
+        }
+        const int c = size_class(size);
+        thread_state& t = local();
+        block* b = static_cast<block*>(p);
+        if (t.exited) {
+            cache fl;
+            b->next = nullptr;
+            fl.head = b;
+            fl.count = 1;
+            flush(c, fl, 1);
+            return;
+        }
+        cache& fl = t.lists[c];
+        b->next = fl.head;
+        fl.head = b;
+        if (++fl.count >= 2*batch_size)
+            flush(c, fl, batch_size);
+    }
+private:
+    struct block {
+        block* next;
+        block* next_batch; // valid for the 1st block of a batch in depot
+    };
+    static_assert(sizeof(block) <= granularity, "block must fit the smallest class");
+
+    struct cache {
+        block* head = nullptr;
+        int count = 0; // approximate, a batch from depot is counted as batch_size
+        block* batches = nullptr; // taken from depot
+    };
+
+    // free lists of current thread. trivially destructible, so no tls guard for every access
+    struct thread_state {
+        cache lists[classes];
+        bool registered;
+        bool exited;
+    };
+
+    // remaining blocks go to depot when thread exits
+    struct exit_hook {
+        ~exit_hook() {
+            thread_state& t = instance().local();
+            for (int c = 0; c < classes; ++c)
+                instance().give_back(c, t.lists[c]);
+            t.exited = true;
+        }
+    };
+
+    slab_arena() = default;
+
+    // plain new only guarantees __STDCPP_DEFAULT_NEW_ALIGNMENT__
+    static void* heap_allocate(size_t size, size_t align) {
+        if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+            return ::operator new(size, std::align_val_t(align));
+        return ::operator new(size);
+    }
+
+    static void heap_deallocate(void* p, size_t align) {
+        if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+            ::operator delete(p, std::align_val_t(align));
+        else
+            ::operator delete(p);
+    }
+
+    static int size_class(size_t size) { return int((size + granularity - 1)/granularity) - 1; }
+
+    thread_state& local() {
+        thread_local thread_state t = {};
+        if (!t.registered) {
+            t.registered = true;
+            thread_local exit_hook h;
+            (void)h;
+        }
+        return t;
+    }
+
+    // push batches [h, e] to depot
+    void push_batches(int c, block* h, block* e) {
+        e->next_batch = depot_[c].load(std::memory_order_relaxed);
+        while (!depot_[c].compare_exchange_weak(e->next_batch, h, std::memory_order_release, std::memory_order_relaxed)) {}
+    }
+
+    // move at most n blocks from fl to depot as a batch
+    void flush(int c, cache& fl, int n) {
+        block* h = fl.head;
+        block* e = h;
+        for (int i = 1; i < n && e->next; ++i)
+            e = e->next;
+        fl.head = e->next;
+        fl.count = fl.head ? std::max(fl.count - n, 1) : 0;
+        e->next = nullptr;
+        push_batches(c, h, h);
+    }
+
+    // move all blocks of fl to depot
+    void give_back(int c, cache& fl) {
+        if (fl.head)
+            flush(c, fl, INT32_MAX);
+        if (block* h = fl.batches) {
+            block* e = h;
+            while (e->next_batch)
+                e = e->next_batch;
+            push_batches(c, h, e);
+            fl.batches = nullptr;
+        }
+    }
+
+    // take a batch taken from depot before, or all batches from depot, or carve a new chunk
+    void refill(int c, cache& fl) {
+        if (!fl.batches)
+            fl.batches = depot_[c].exchange(nullptr, std::memory_order_acquire);
+        if (block* b = fl.batches) {
+            fl.batches = b->next_batch;
+            fl.head = b;
+            fl.count = batch_size;
+            return;
+        }
+        const size_t size = (c + 1)*granularity;
+        char* chunk = static_cast<char*>(::operator new(chunk_size));
+        block* link = reinterpret_cast<block*>(chunk); // 1st block links chunks
+        link->next = chunks_.load(std::memory_order_relaxed);
+        while (!chunks_.compare_exchange_weak(link->next, link, std::memory_order_release, std::memory_order_relaxed)) {}
+        for (size_t off = max_size; off + size <= chunk_size; off += size) { // keep chunk head aligned to any class
+            block* i = reinterpret_cast<block*>(chunk + off);
+            i->next = fl.head;
+            fl.head = i;
+            fl.count++;
+        }
+    }
+
+    std::atomic<block*> depot_[classes] = {};
+    std::atomic<block*> chunks_ = {nullptr}; // for leak checkers
+};
+
+// stateless, std::allocator compatible. can be used by hazard pointer protected queues
+template<typename T>
+class slab_allocator {
+public:
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    slab_allocator() = default;
+    template<typename U>
+    slab_allocator(const slab_allocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(slab_arena::instance().allocate(n*sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_t n) {
+        slab_arena::instance().deallocate(p, n*sizeof(T), alignof(T));
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const slab_allocator<T>&, const slab_allocator<U>&) { return true; }
+template<typename T, typename U>
+bool operator!=(const slab_allocator<T>&, const slab_allocator<U>&) { return false; }
+} // namespace lockless
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2026 WangBin <wbsecg1 at gmail.com>
+ * MIT License
+ * Wait Free Bounded SPSC FIFO
+ * https://github.com/wang-bin/lockless
+ */
+#pragma once
+#include <atomic>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include "cacheline.h"
+#include "eventcount.h"
+#include "stats.h"
+
+// array based, no allocation after construction. producer only writes in_, consumer only writes out_
+template<typename T, typename C, class Stats, class Wait>
+class spsc_bounded_fifo_api : private Stats {
+public:
+    // return number of element cleared
+    int clear() {
+        int n = 0;
+        while (try_pop())
+            n++;
+        return n;
+    } // in consumer thread
+
+    // return false if full
+    template<typename... Args>
+    bool try_emplace(Args&&... args) {
+        const size_t in = in_.load(std::memory_order_relaxed);
+        const size_t next = index(in + 1);
+        if (next == out_cached_) {
+            out_cached_ = out_.load(std::memory_order_acquire); // slot of out_cached_ may be still in use by consumer
+            if (next == out_cached_)
+                return false;
+        }
+        data_[in].~T(); // already default constructed, so destruct first
+        new (&data_[in]) T{std::forward<Args>(args)...};
+        in_.store(next, std::memory_order_release);
+        Stats::on_push();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    template<typename U>
+    bool try_push(U&& v) {
+        const size_t in = in_.load(std::memory_order_relaxed);
+        const size_t next = index(in + 1);
+        if (next == out_cached_) {
+            out_cached_ = out_.load(std::memory_order_acquire);
+            if (next == out_cached_)
+                return false;
+        }
+        data_[in] = std::forward<U>(v);
+        in_.store(next, std::memory_order_release); // ensure data_[in] is written
+        Stats::on_push();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // return false if empty
+    bool try_pop(T* v = nullptr) {
+        const size_t out = out_.load(std::memory_order_relaxed);
+        if (out == in_cached_) {
+            in_cached_ = in_.load(std::memory_order_acquire);
+            if (out == in_cached_) {
+                Stats::on_pop_fail();
+                return false;
+            }
+        }
+        if (v)
+            *v = std::move(data_[out]);
+        out_.store(index(out + 1), std::memory_order_release); // data_[out] can be overwritten now
+        Stats::on_pop();
+        not_full_.notify_one();
+        return true;
+    }
+
+    lockless::queue_stats stats() const {
+        return Stats::snapshot();
+    }
+
+    // block until v is pushed
+    template<typename U>
+    void wait_push(U&& v) {
+        not_full_.await([&]{ return try_push(std::forward<U>(v)); }); // v is not moved if try_push() fails
+    }
+
+    // return false if v is not pushed before timeout
+    template<typename U, class Rep, class Period>
+    bool wait_push_for(U&& v, const std::chrono::duration<Rep, Period>& timeout) {
+        return not_full_.await_for([&]{ return try_push(std::forward<U>(v)); }, timeout);
+    }
+
+    // block until an element is popped
+    void wait_pop(T* v = nullptr) {
+        not_empty_.await([this, v]{ return try_pop(v); });
+    }
+
+    // return false if no element is popped before timeout
+    template<class Rep, class Period>
+    bool wait_pop_for(T* v, const std::chrono::duration<Rep, Period>& timeout) {
+        return not_empty_.await_for([this, v]{ return try_pop(v); }, timeout);
+    }
+
+    size_t capacity() const { return std::size(data_) - 1; }
+    // approximate if called in neither producer nor consumer thread
+    size_t size() const {
+        const size_t in = in_.load(std::memory_order_acquire);
+        const size_t out = out_.load(std::memory_order_acquire);
+        return in < out ? extent() - (out - in) : in - out;
+    }
+    bool empty() const { return size() == 0;}
+protected:
+    size_t extent() const { return capacity() + 1; }
+    size_t index(size_t i) const { return i < extent() ? i : i - extent();} // i is always in [0,extent())
+
+//  [1, 2, ..., cap, extent]. in_ and out_cached_ are producer data, out_ and in_cached_ are consumer data
+    alignas(lockless::cacheline_size) std::atomic<size_t> in_ = {0};
+    size_t out_cached_ = 0;
+    alignas(lockless::cacheline_size) std::atomic<size_t> out_ = {0};
+    size_t in_cached_ = 0;
+    alignas(lockless::cacheline_size) Wait not_empty_; // read by every push and pop
+    Wait not_full_;
+    alignas(lockless::cacheline_size) C data_;
+};
+
+template<typename T, class Stats = lockless::null_stats, class Wait = lockless::spin_wait>
+class spsc_bounded_fifo : public spsc_bounded_fifo_api<T, std::vector<T>, Stats, Wait> {
+    using api = spsc_bounded_fifo_api<T, std::vector<T>, Stats, Wait>;
+    using api::data_;
+public:
+    spsc_bounded_fifo(size_t cap) : api() {
+        data_.resize(cap + 1);
+    }
+};
+
+template<typename T, int N, class Stats = lockless::null_stats, class Wait = lockless::spin_wait>
+class static_spsc_bounded_fifo : public spsc_bounded_fifo_api<T, T[N+1], Stats, Wait> {
+};
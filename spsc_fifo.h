@@ -7,17 +7,23 @@
  */
 #pragma once
 #include <atomic>
+#include <memory>
 #include <utility>
+#include "eventcount.h"
+#include "stats.h"
 
 // namespace lockless { namespace spsc {}}
-template<typename T>
-class spsc_fifo {
+template<typename T, class Stats = lockless::null_stats, class Allocator = std::allocator<T>, class Wait = lockless::spin_wait>
+class spsc_fifo : private Stats {
 public:
-    spsc_fifo() { in_.store(out_); }
+    spsc_fifo(const Allocator& a = Allocator()) : alloc_(a) {
+        out_ = new_node();
+        in_.store(out_);
+    }
 
     ~spsc_fifo() {
         clear();
-        delete out_;
+        delete_node(out_);
     }
 
     // return number of element cleared
@@ -30,37 +36,80 @@ public:
 
     template<typename... Args>
     void emplace(Args&&... args) {
-        node *n = new node{std::forward<Args>(args)...};
+        node *n = new_node(std::forward<Args>(args)...);
         node* t = in_.load(std::memory_order_relaxed);
         t->next = n;
         in_.store(n, std::memory_order_release);
+        Stats::on_push();
+        not_empty_.notify_one();
     }
 
     template<typename U>
     void push(U&& v) {
-        node *n = new node{std::forward<U>(v)};
+        node *n = new_node(std::forward<U>(v));
         node* t = in_.load(std::memory_order_relaxed);
         t->next = n;
         in_.store(n, std::memory_order_release); // ensure t->next is written
+        Stats::on_push();
+        not_empty_.notify_one();
     }
 
     bool pop(T* v = nullptr) {
-        if (out_ == in_.load(std::memory_order_acquire)) //if (!head->next) // not completely write to head->next (tail->next), next is not null but invalid
+        if (out_ == in_.load(std::memory_order_acquire)) {//if (!head->next) // not completely write to head->next (tail->next), next is not null but invalid
+            Stats::on_pop_fail();
             return false;
+        }
         node *h = out_;
         out_ = h->next;
         if (v)
             *v = std::move(h->next->v);
-        delete h;
+        delete_node(h);
+        Stats::on_pop();
         return true;
     }
+
+    lockless::queue_stats stats() const {
+        return Stats::snapshot();
+    }
+
+    // block until an element is popped
+    void wait_pop(T* v = nullptr) {
+        not_empty_.await([this, v]{ return pop(v); });
+    }
+
+    // return false if no element is popped before timeout
+    template<class Rep, class Period>
+    bool wait_pop_for(T* v, const std::chrono::duration<Rep, Period>& timeout) {
+        return not_empty_.await_for([this, v]{ return pop(v); }, timeout);
+    }
 private:
     struct node {
         T v;
         node *next;
     };
 
-    node *out_ = new node();
+    using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<node>;
+    using node_traits = std::allocator_traits<node_allocator>;
+
+    template<typename... Args>
+    node* new_node(Args&&... args) {
+        node* n = node_traits::allocate(alloc_, 1);
+        try {
+            return ::new (n) node{std::forward<Args>(args)...};
+        } catch (...) {
+            node_traits::deallocate(alloc_, n, 1);
+            throw;
+        }
+    }
+
+    void delete_node(node* n) {
+        n->~node();
+        node_traits::deallocate(alloc_, n, 1);
+    }
+
+    node_allocator alloc_;
+    node *out_ = nullptr;
     std::atomic<node*> in_; // can not use in_{out_} because atomic ctor with desired value MUST be constexpr (error in g++4.8 iff use template)
+    Wait not_empty_;
 };
 
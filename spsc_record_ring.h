@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2026 WangBin <wbsecg1 at gmail.com>
+ * MIT License
+ * Wait Free SPSC Variable Length Record Ring
+ * https://github.com/wang-bin/lockless
+ */
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include "cacheline.h"
+
+// records of any size are stored inline as {8 bytes length, payload}, aligned to 8 bytes. no allocation and no copy after construction
+// producer: span = reserve(max); fill span.data; commit(size). consumer: span = peek(); read span.data; release()
+// if a record does not fit the end of buffer, a skip marker is published there and the record starts at the beginning.
+// in_ and out_ are positions increased forever, producer only writes in_, consumer only writes out_
+namespace lockless {
+
+template<typename T>
+struct record_span {
+    T* data = nullptr;
+    size_t size = 0;
+
+    explicit operator bool() const { return !!data; }
+};
+
+class spsc_record_ring {
+public:
+    // capacity in bytes, including record headers. rounded up to 8. throw std::invalid_argument if 0
+    spsc_record_ring(size_t cap) : cap_(checked_capacity(cap)), data_(new uint64_t[cap_/align]) {}
+
+    size_t capacity() const { return cap_; }
+    // the largest payload can be reserved in an empty ring
+    size_t max_record_size() const { return cap_ - header_size; }
+    // approximate bytes used including headers and skipped bytes, if called in neither producer nor consumer thread
+    size_t size() const { return in_.load(std::memory_order_acquire) - out_.load(std::memory_order_acquire); }
+    bool empty() const { return size() == 0; }
+
+    // producer: writable span of n bytes, or empty if no enough space. a reserved record is invisible to consumer until commit()
+    record_span<uint8_t> reserve(size_t n) {
+        reserved_ = false;
+        const size_t need = record_size(n);
+        if (need > cap_)
+            return {};
+        uint64_t in = in_.load(std::memory_order_relaxed);
+        size_t off = size_t(in % cap_);
+        if (off + need > cap_) { // publish a skip marker, so consumer can free the end of buffer even if the record does not fit now
+            const size_t skip = cap_ - off;
+            if (!has_space(in, skip))
+                return {};
+            header(off) = skip_marker;
+            in += skip;
+            in_.store(in, std::memory_order_release);
+            off = 0;
+        }
+        if (!has_space(in, need))
+            return {};
+        reserved_off_ = off;
+        reserved_size_ = n;
+        reserved_ = true;
+        return {bytes() + off + header_size, n};
+    }
+
+    // producer: publish the last reserved record with n <= reserved bytes. no-op if the last reserve() failed or is already committed
+    void commit(size_t n) {
+        if (!reserved_)
+            return;
+        reserved_ = false;
+        if (n > reserved_size_)
+            n = reserved_size_;
+        header(reserved_off_) = n;
+        in_.store(in_.load(std::memory_order_relaxed) + record_size(n), std::memory_order_release);
+    }
+    void commit() { commit(reserved_size_); }
+
+    // consumer: the first record, or empty if no record
+    record_span<const uint8_t> peek() {
+        peeked_ = false;
+        uint64_t out = out_.load(std::memory_order_relaxed);
+        for (;;) {
+            if (out == in_cached_) {
+                in_cached_ = in_.load(std::memory_order_acquire);
+                if (out == in_cached_)
+                    return {};
+            }
+            const size_t off = size_t(out % cap_);
+            const uint64_t h = header(off);
+            if (h != skip_marker) {
+                peeked_ = true;
+                peeked_size_ = size_t(h);
+                return {bytes() + off + header_size, size_t(h)};
+            }
+            out += cap_ - off;
+            out_.store(out, std::memory_order_release);
+        }
+    }
+
+    // consumer: free the record returned by peek(). no-op if the last peek() returned empty or is already released
+    void release() {
+        if (!peeked_)
+            return;
+        peeked_ = false;
+        out_.store(out_.load(std::memory_order_relaxed) + record_size(peeked_size_), std::memory_order_release);
+    }
+private:
+    static constexpr size_t align = 8;
+    static constexpr size_t header_size = 8;
+    static constexpr uint64_t skip_marker = UINT64_MAX; // the rest of buffer is not used
+
+    static size_t checked_capacity(size_t cap) {
+        if (cap == 0)
+            throw std::invalid_argument("spsc_record_ring capacity is 0");
+        return (cap + align - 1)/align*align;
+    }
+
+    static size_t record_size(size_t n) { return header_size + (n + align - 1)/align*align; }
+
+    bool has_space(uint64_t in, size_t n) {
+        if (cap_ - (in - out_cached_) >= n)
+            return true;
+        out_cached_ = out_.load(std::memory_order_acquire); // space before out_ is released by consumer
+        return cap_ - (in - out_cached_) >= n;
+    }
+
+    uint8_t* bytes() const { return reinterpret_cast<uint8_t*>(data_.get()); }
+    uint64_t& header(size_t off) const { return data_[off/align]; }
+
+    const size_t cap_;
+    const std::unique_ptr<uint64_t[]> data_;
+    alignas(cacheline_size) std::atomic<uint64_t> in_ = {0};
+    uint64_t out_cached_ = 0;
+    size_t reserved_off_ = 0;
+    size_t reserved_size_ = 0;
+    bool reserved_ = false; // reserve() succeeded and not committed
+    alignas(cacheline_size) std::atomic<uint64_t> out_ = {0};
+    uint64_t in_cached_ = 0;
+    size_t peeked_size_ = 0;
+    bool peeked_ = false; // peek() returned a record and not released
+};
+} // namespace lockless
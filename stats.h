@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2026 WangBin <wbsecg1 at gmail.com>
+ * MIT License
+ * Queue Statistics Policy
+ * https://github.com/wang-bin/lockless
+ */
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include "cacheline.h"
+
+// queues inherit Stats privately like ring_api and Mutex. null_stats is empty and all hooks are no-op, so it costs nothing.
+// e.g. mpmc_fifo<T, lockless::sharded_stats<>> q; auto s = q.stats();
+namespace lockless {
+
+// per queue. reclamation backlog is shared by all hazard pointer protected queues, see lockless::hazard_domain::instance().backlog()
+struct queue_stats {
+    uint64_t pushes = 0;
+    uint64_t pops = 0;
+    uint64_t failed_pops = 0;
+    uint64_t cas_retries = 0; // failed CAS in push/pop loops
+    int64_t size = 0; // pushes - pops
+    int64_t peak_size = 0; // sampled, see sharded_stats
+};
+
+struct null_stats {
+    void on_push(uint64_t = 1) {}
+    void on_pop(uint64_t = 1) {}
+    void on_pop_fail() {}
+    void on_cas_retry(uint64_t) {}
+    queue_stats snapshot() const { return {}; }
+};
+
+// index of current thread in first use order, to pick a counter shard
+inline int thread_shard() {
+    static std::atomic<int> next = {0};
+    thread_local const int id = next.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+// counters are sharded by thread to avoid bouncing a shared cache line. peak_size is sampled by a thread every 64 pushes of it
+template<int Shards = 16>
+class sharded_stats {
+    static_assert((Shards & (Shards - 1)) == 0, "Shards must be power of 2");
+public:
+    void on_push(uint64_t n = 1) {
+        const uint64_t old = shard().pushes.fetch_add(n, std::memory_order_relaxed);
+        if ((old ^ (old + n)) >> 6) // every 64 pushes
+            sample_peak();
+    }
+    void on_pop(uint64_t n = 1) { shard().pops.fetch_add(n, std::memory_order_relaxed); }
+    void on_pop_fail() { shard().failed_pops.fetch_add(1, std::memory_order_relaxed); }
+    void on_cas_retry(uint64_t n) {
+        if (n)
+            shard().cas_retries.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    queue_stats snapshot() const {
+        queue_stats st;
+        for (const auto& s : shards_) {
+            st.pushes += s.pushes.load(std::memory_order_relaxed);
+            st.pops += s.pops.load(std::memory_order_relaxed);
+            st.failed_pops += s.failed_pops.load(std::memory_order_relaxed);
+            st.cas_retries += s.cas_retries.load(std::memory_order_relaxed);
+        }
+        st.size = int64_t(st.pushes - st.pops);
+        st.peak_size = std::max(st.size, peak_.load(std::memory_order_relaxed));
+        return st;
+    }
+private:
+    struct alignas(cacheline_size) counters {
+        std::atomic<uint64_t> pushes = {0};
+        std::atomic<uint64_t> pops = {0};
+        std::atomic<uint64_t> failed_pops = {0};
+        std::atomic<uint64_t> cas_retries = {0};
+    };
+
+    counters& shard() { return shards_[thread_shard() & (Shards - 1)]; }
+
+    void sample_peak() {
+        int64_t size = 0;
+        for (const auto& s : shards_)
+            size += int64_t(s.pushes.load(std::memory_order_relaxed) - s.pops.load(std::memory_order_relaxed));
+        int64_t peak = peak_.load(std::memory_order_relaxed);
+        while (size > peak && !peak_.compare_exchange_weak(peak, size, std::memory_order_relaxed)) {}
+    }
+
+    counters shards_[Shards];
+    alignas(cacheline_size) std::atomic<int64_t> peak_ = {0};
+};
+
+// pushes and pops only, sharded like sharded_stats. the cheapest Stats with size, e.g. for queue::size_approx()
+template<int Shards = 16>
+class size_stats {
+    static_assert((Shards & (Shards - 1)) == 0, "Shards must be power of 2");
+public:
+    void on_push(uint64_t n = 1) { shard().pushes.fetch_add(n, std::memory_order_relaxed); }
+    void on_pop(uint64_t n = 1) { shard().pops.fetch_add(n, std::memory_order_relaxed); }
+    void on_pop_fail() {}
+    void on_cas_retry(uint64_t) {}
+
+    queue_stats snapshot() const {
+        queue_stats st;
+        for (const auto& s : shards_) {
+            st.pushes += s.pushes.load(std::memory_order_relaxed);
+            st.pops += s.pops.load(std::memory_order_relaxed);
+        }
+        st.size = int64_t(st.pushes - st.pops);
+        return st;
+    }
+private:
+    struct alignas(cacheline_size) counters {
+        std::atomic<uint64_t> pushes = {0};
+        std::atomic<uint64_t> pops = {0};
+    };
+
+    counters& shard() { return shards_[thread_shard() & (Shards - 1)]; }
+
+    counters shards_[Shards];
+};
+} // namespace lockless
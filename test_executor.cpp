@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2026 WangBin <wbsecg1 at gmail.com>
+ * MIT License
+ * https://github.com/wang-bin/lockless
+ */
+
+#include "executor.h"
+#include "mpmc_fifo.h"
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <iostream>
+#include <chrono>
+#include <vector>
+
+using namespace std;
+using namespace chrono;
+
+#define TEST(expr) do { \
+        if (!(expr)) { \
+                std::cerr << __LINE__ << " test error: " << #expr << std::endl; \
+                exit(1); \
+        } \
+} while(false)
+
+static const int N = 200000;
+static const int NT = 4;
+
+static_assert(std::is_trivially_copyable<lockless::task::raw>::value, "raw task must be trivially copyable");
+static_assert(sizeof(lockless::task::raw) == 64, "task is 1 cache line");
+
+// counts destructor calls of copies
+struct counted {
+    static int live;
+    counted() { live++; }
+    counted(const counted&) { live++; }
+    ~counted() { live--; }
+};
+int counted::live = 0;
+
+bool test_task_not_run() {
+    cout << "testing task destroyed without run..." << std::endl;
+    int n = 0;
+    {
+        counted c;
+        lockless::task t([c, &n]{ n++; }); // boxed
+        TEST(counted::live == 2);
+        lockless::task m(std::move(t));
+        TEST(!t && m && counted::live == 2);
+        lockless::task small([&n]{ n++; }); // inline
+        lockless::task k([c, &n]{ n++; });
+        k(); // consumed
+        TEST(!k && n == 1 && counted::live == 2);
+    }
+    return counted::live == 0 && n == 1;
+}
+
+bool test_submit() {
+    cout << "testing executor submit from outside..." << std::endl;
+    atomic<int> count{0};
+    {
+        lockless::executor ex(NT);
+        for (int i = 0; i < N; ++i)
+            ex.submit([&count]{ count.fetch_add(1, memory_order_relaxed); });
+    } // remaining tasks are executed
+    return count == N;
+}
+
+bool test_boxed() {
+    cout << "testing executor boxed task..." << std::endl;
+    atomic<int> count{0};
+    auto p = make_shared<int>(1); // not trivially copyable
+    char big[128] = {1}; // larger than sbo
+    {
+        lockless::executor ex(NT);
+        for (int i = 0; i < N/10; ++i) {
+            ex.submit([&count, p]{ count.fetch_add(*p, memory_order_relaxed); });
+            ex.submit([&count, big]{ count.fetch_add(big[0], memory_order_relaxed); });
+        }
+    }
+    return count == N/5 && p.use_count() == 1;
+}
+
+// tasks submitted by workers go to local deques and are stolen by others
+static void spawn(lockless::executor& ex, atomic<int>& count, int depth) {
+    count.fetch_add(1, memory_order_relaxed);
+    if (depth == 0)
+        return;
+    ex.submit([&ex, &count, depth]{ spawn(ex, count, depth - 1); });
+    ex.submit([&ex, &count, depth]{ spawn(ex, count, depth - 1); });
+}
+
+bool test_nested() {
+    cout << "testing executor nested submit..." << std::endl;
+    atomic<int> count{0};
+    {
+        lockless::executor ex(NT);
+        ex.submit([&ex, &count]{ spawn(ex, count, 16); });
+    }
+    return count == (1 << 17) - 1;
+}
+
+bool test_parallel_for() {
+    cout << "testing executor parallel_for..." << std::endl;
+    lockless::executor ex(NT);
+    vector<int> v(N);
+    ex.parallel_for(0, N, [&v](int i) { v[i] = i; });
+    for (int i = 0; i < N; ++i) {
+        if (v[i] != i)
+            return false;
+    }
+    atomic<long long> sum{0};
+    ex.submit([&ex, &sum]{ // nested parallel_for in a worker
+        ex.parallel_for(0, 1000, [&sum](int i) { sum += i; }, 10);
+    });
+    while (sum < 999*1000/2)
+        this_thread::yield();
+    return sum == 999*1000/2;
+}
+
+// what everyone writes: workers spin on a shared mpmc_fifo
+class naive_pool {
+public:
+    naive_pool(int threads) {
+        for (int i = 0; i < threads; ++i) {
+            workers_.emplace_back([this]{
+                function<void()> f;
+                while (!stop_) {
+                    if (q_.pop(&f))
+                        f();
+                }
+                while (q_.pop(&f))
+                    f();
+            });
+        }
+    }
+    ~naive_pool() {
+        stop_ = true;
+        for (auto& t : workers_)
+            t.join();
+    }
+    template<typename F>
+    void submit(F&& f) { q_.push(function<void()>(std::forward<F>(f))); }
+private:
+    mpmc_fifo<function<void()>> q_;
+    atomic<bool> stop_{false};
+    vector<thread> workers_;
+};
+
+template<class Pool>
+long long submit_throughput() {
+    atomic<int> count{0};
+    const auto t0 = steady_clock::now();
+    {
+        Pool pool(NT);
+        for (int i = 0; i < N; ++i)
+            pool.submit([&count]{ count.fetch_add(1, memory_order_relaxed); });
+    }
+    TEST(count == N);
+    return duration_cast<milliseconds>(steady_clock::now() - t0).count();
+}
+
+bool test_throughput() {
+    cout << "testing executor throughput vs naive mpmc_fifo pool..." << std::endl;
+    const auto te = submit_throughput<lockless::executor>();
+    const auto tn = submit_throughput<naive_pool>();
+    cout << "executor: " << te << "ms, naive pool: " << tn << "ms" << std::endl;
+    return true;
+}
+
+int main()
+{
+    auto t0 = steady_clock::now();
+    TEST(test_task_not_run());
+    TEST(test_submit());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_boxed());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_nested());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_parallel_for());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_throughput());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    return 0;
+}
@@ -5,9 +5,22 @@
  */
 
 #include "spsc_fifo.h"
+#include "spsc_bounded_fifo.h"
 #include "mpsc_fifo.h"
 #include "mpmc_fifo.h"
+#include "mpmc_bounded_fifo.h"
+#include "slab_allocator.h"
+#include "shm_fifo.h"
+#include "spsc_record_ring.h"
+#include "queue.h"
+#include "sharded_fifo.h"
 #include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
 #include <thread>
 #include <iostream>
 #include <chrono>
@@ -32,6 +45,7 @@ struct X {
 
 static const int N = 500000;
 static const int NT = 6;
+static const int B = 64; // batch size
 
 bool test_spsc_push_count() {
     cout << "testing spsc push count..." << std::endl;
@@ -63,6 +77,43 @@ bool test_spsc_rw() {
     return true;
 }
 
+bool test_spsc_bounded_push_count() {
+    cout << "testing spsc bounded push count..." << std::endl;
+    spsc_bounded_fifo<X> ss(N);
+    for (int i = 0; i < N; ++i)
+        TEST(ss.try_emplace(i, float(i)));
+    TEST(!ss.try_push(X{N, float(N)}));
+    return ss.clear() == N;
+}
+
+bool test_spsc_bounded_rw() {
+    cout << "testing spsc bounded rw..." << std::endl;
+    spsc_bounded_fifo<X> ss(1024);
+    thread tssp([&ss]{
+        for (int i = 0; i < N; ++i) {
+            while (!ss.try_emplace(i, float(i)))
+                this_thread::yield();
+        }
+    });
+    int fail = 0;
+    thread tssc([&ss, &fail]{
+        for (int i = 0; i < N;) {
+            X x;
+            if (!ss.try_pop(&x)) {
+                fail++;
+                this_thread::yield();
+                continue;
+            }
+            TEST(x.a == i);
+            ++i;
+        }
+    });
+    tssc.join();
+    tssp.join();
+    printf("spsc bounded pop fail count: %d\n", fail);
+    return ss.clear() == 0;
+}
+
 bool test_mpsc_push_count() {
     cout << "testing mpsc push count..." << std::endl;
     mpsc_fifo<X> ms;
@@ -104,6 +155,33 @@ bool test_mpsc_rw() {
     return true;
 }
 
+bool test_mpsc_rw_batch() {
+    cout << "testing mpsc rw batch..." << std::endl;
+    mpsc_fifo<X> ms;
+    thread tmsp[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmsp[k] = thread([&ms]{
+            X xs[B];
+            for (int i = 0; i < N; i += B) {
+                for (int j = 0; j < B; ++j)
+                    xs[j] = X{i + j, float(i + j)};
+                ms.push_range(xs, xs + B);
+            }
+        });
+    }
+    thread tmsc([&ms]{
+        X xs[B];
+        for (int i = 0; i < N*NT/B; ++i) {
+            ms.pop_batch(xs, B);
+        }
+    });
+    tmsc.join();
+    for (auto& t : tmsp)
+        t.join();
+    printf("mpsc batch pop left count: %d\n", ms.clear());
+    return true;
+}
+
 bool test_mpmc_push_count() {
     cout << "testing mpmc push count..." << std::endl;
     mpmc_fifo<X> mm;
@@ -150,6 +228,666 @@ bool test_mpmc_rw() {
     return true;
 }
 
+bool test_mpmc_rw_batch() {
+    cout << "testing mpmc rw batch..." << std::endl;
+    mpmc_fifo<X> mm;
+    thread tmmp[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmmp[k] = thread([&mm]{
+            X xs[B];
+            for (int i = 0; i < N; i += B) {
+                for (int j = 0; j < B; ++j)
+                    xs[j] = X{i + j, float(i + j)};
+                mm.push_range(xs, xs + B);
+            }
+        });
+    }
+    thread tmmc[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmmc[k] = thread([&mm]{
+            X xs[B];
+            for (int i = 0; i < N/B; ++i) {
+                mm.pop_batch(xs, B);
+            }
+        });
+    }
+    for (auto& t : tmmc)
+        t.join();
+    for (auto& t : tmmp)
+        t.join();
+    printf("mpmc batch pop left count: %d\n", mm.clear());
+    return true;
+}
+
+template<class Wait>
+bool test_mpmc_wait_pop() {
+    cout << "testing mpmc wait pop..." << std::endl;
+    mpmc_fifo<X, lockless::null_stats, std::allocator<X>, Wait> mm;
+    X x;
+    TEST(!mm.wait_pop_for(&x, milliseconds(10)));
+    thread tmmp[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmmp[k] = thread([&mm]{
+            for (int i = 0; i < N; ++i) {
+                mm.emplace(i, float(i));
+            }
+        });
+    }
+    thread tmmc[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmmc[k] = thread([&mm]{
+            for (int i = 0; i < N; ++i) {
+                X x;
+                mm.wait_pop(&x);
+            }
+        });
+    }
+    for (auto& t : tmmc)
+        t.join();
+    for (auto& t : tmmp)
+        t.join();
+    return mm.clear() == 0;
+}
+
+bool test_mpmc_stats() {
+    cout << "testing mpmc stats..." << std::endl;
+    mpmc_fifo<X, lockless::sharded_stats<>> mm;
+    thread tmmp[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmmp[k] = thread([&mm]{
+            for (int i = 0; i < N; ++i)
+                mm.emplace(i, float(i));
+        });
+    }
+    for (auto& t: tmmp)
+        t.join();
+    auto s = mm.stats();
+    TEST(s.pushes == N*NT && s.pops == 0 && s.size == N*NT && s.peak_size == N*NT);
+    mm.clear();
+    s = mm.stats();
+    printf("mpmc stats pushes: %llu, pops: %llu, failed pops: %llu, cas retries: %llu, peak size: %lld, reclaim backlog(global): %zu\n"
+        , (unsigned long long)s.pushes, (unsigned long long)s.pops, (unsigned long long)s.failed_pops, (unsigned long long)s.cas_retries
+        , (long long)s.peak_size, lockless::hazard_domain::instance().backlog());
+    return s.pops == N*NT && s.failed_pops == 1 && s.size == 0;
+}
+
+static const void* hp_protected = nullptr;
+static bool hp_protected_deleted = false;
+
+static void delete_int(void* p) {
+    hp_protected_deleted |= p == hp_protected;
+    delete static_cast<int*>(p);
+}
+
+// an inner guard clears only its own slot
+bool test_hazard_guard_nested() {
+    cout << "testing nested hazard guards..." << std::endl;
+    auto& d = lockless::hazard_domain::instance();
+    int* p = new int(1);
+    hp_protected = p;
+    lockless::hazard_guard outer;
+    outer.set(0, p);
+    {
+        lockless::hazard_guard inner;
+        int x = 0;
+        inner.set(1, &x);
+    }
+    outer.retire(p, delete_int);
+    for (size_t i = 0; i <= d.threshold(); ++i) // scan at least once
+        outer.retire(new int(0), delete_int);
+    TEST(!hp_protected_deleted);
+    outer.clear();
+    for (size_t i = 0; i <= d.threshold(); ++i)
+        outer.retire(new int(0), delete_int);
+    return hp_protected_deleted;
+}
+
+// retired nodes are reclaimed no matter how many are popped: at most threshold() per thread record
+bool test_mpmc_reclaim_backlog() {
+    cout << "testing mpmc reclaim backlog..." << std::endl;
+    mpmc_fifo<X> mm;
+    const auto& d = lockless::hazard_domain::instance();
+    std::atomic<int> n{0};
+    std::atomic<uint64_t> peak{0};
+    thread tmmp[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmmp[k] = thread([&mm]{
+            for (int i = 0; i < N; ++i)
+                mm.emplace(i, float(i));
+        });
+    }
+    thread tmmc[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmmc[k] = thread([&mm, &d, &n, &peak]{
+            while (n < N*NT) {
+                if (!mm.pop()) {
+                    this_thread::yield();
+                    continue;
+                }
+                if (++n % 256 == 0) {
+                    const uint64_t b = d.backlog();
+                    uint64_t p = peak.load();
+                    while (b > p && !peak.compare_exchange_weak(p, b)) {}
+                }
+            }
+        });
+    }
+    for (auto& t : tmmc)
+        t.join();
+    for (auto& t : tmmp)
+        t.join();
+    printf("mpmc reclaim backlog peak: %llu, records: %d, threshold: %zu\n", (unsigned long long)peak.load(), d.records(), d.threshold());
+    return peak > 0 && peak <= uint64_t(d.records())*d.threshold();
+}
+
+bool test_mpmc_bounded_push_count() {
+    cout << "testing mpmc bounded push count..." << std::endl;
+    mpmc_bounded_fifo<X> mm(N*NT);
+    thread tmmp[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmmp[k] = thread([&mm]{
+            for (int i = 0; i < N; ++i)
+                TEST(mm.try_emplace(i, float(i)));
+        });
+    }
+    for (auto& t: tmmp)
+        t.join();
+    return mm.clear() == N*NT;
+}
+
+bool test_mpmc_bounded_rw() {
+    cout << "testing mpmc bounded rw..." << std::endl;
+    mpmc_bounded_fifo<X> mm(1024);
+    thread tmmp[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmmp[k] = thread([&mm]{
+            for (int i = 0; i < N; ++i) {
+                while (!mm.try_emplace(i, float(i)))
+                    this_thread::yield();
+            }
+        });
+    }
+    std::atomic<int> fail{0};
+    thread tmmc[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmmc[k] = thread([&mm, &fail]{
+            for (int i = 0; i < N;) {
+                X x;
+                if (!mm.try_pop(&x)) {
+                    fail++;
+                    this_thread::yield();
+                    continue;
+                }
+                ++i;
+            }
+        });
+    }
+    for (auto& t : tmmc)
+        t.join();
+    for (auto& t : tmmp)
+        t.join();
+    printf("mpmc bounded pop fail count: %d\n", fail.load());
+    return mm.clear() == 0;
+}
+
+static std::atomic<int> live_nodes{0};
+
+// stateless, counts live nodes of all queues using it
+template<typename T>
+struct counting_allocator : lockless::slab_allocator<T> {
+    template<typename U> struct rebind { using other = counting_allocator<U>; };
+
+    counting_allocator() = default;
+    template<typename U>
+    counting_allocator(const counting_allocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        live_nodes += int(n);
+        return lockless::slab_allocator<T>::allocate(n);
+    }
+    void deallocate(T* p, size_t n) {
+        live_nodes -= int(n);
+        lockless::slab_allocator<T>::deallocate(p, n);
+    }
+};
+
+bool test_mpsc_allocator() {
+    cout << "testing mpsc allocator..." << std::endl;
+    {
+        mpsc_fifo<X, lockless::null_stats, counting_allocator<X>> ms;
+        thread tmsp[NT];
+        for (int k = 0; k < NT; ++k) {
+            tmsp[k] = thread([&ms]{
+                for (int i = 0; i < N; ++i)
+                    ms.emplace(i, float(i));
+            });
+        }
+        int n = 0;
+        while (n < N*NT) {
+            if (ms.pop())
+                n++;
+            else
+                this_thread::yield();
+        }
+        for (auto& t : tmsp)
+            t.join();
+        TEST(live_nodes == 1); // dummy node
+    }
+    return live_nodes == 0;
+}
+
+// copy throws when the source is negative
+struct throw_x {
+    int v;
+    throw_x(int i = 0) : v(i) {}
+    throw_x(const throw_x& o) : v(o.v) {
+        if (v < 0)
+            throw std::runtime_error("copy");
+    }
+    throw_x& operator=(const throw_x&) = default;
+};
+
+template<class Q>
+bool push_range_throw(Q& q) {
+    const throw_x xs[] = {1, 2, -3, 4};
+    const int live = live_nodes;
+    bool thrown = false;
+    try {
+        q.push_range(xs, xs + 4);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    TEST(thrown && live_nodes == live); // partial chain is freed
+    TEST(!q.pop() && q.push_range(xs, xs + 2) == 2);
+    throw_x x;
+    TEST(q.pop(&x) && x.v == 1);
+    return q.pop(&x) && x.v == 2 && !q.pop();
+}
+
+bool test_push_range_throw() {
+    cout << "testing push range exception..." << std::endl;
+    {
+        mpsc_fifo<throw_x, lockless::null_stats, counting_allocator<throw_x>> ms;
+        TEST(push_range_throw(ms));
+    }
+    TEST(live_nodes == 0);
+    mpmc_fifo<throw_x, lockless::null_stats, counting_allocator<throw_x>> mm; // popped nodes are retired, so live_nodes is not 0 after destruction
+    return push_range_throw(mm);
+}
+
+bool test_mpmc_slab_rw() {
+    cout << "testing mpmc slab allocator rw..." << std::endl;
+    mpmc_fifo<X, lockless::null_stats, lockless::slab_allocator<X>> mm;
+    thread tmmp[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmmp[k] = thread([&mm]{
+            for (int i = 0; i < N; ++i)
+                mm.emplace(i, float(i));
+        });
+    }
+    std::atomic<int> n{0};
+    thread tmmc[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmmc[k] = thread([&mm, &n]{
+            X x;
+            while (n < N*NT) {
+                if (mm.pop(&x))
+                    n++;
+                else
+                    this_thread::yield();
+            }
+        });
+    }
+    for (auto& t : tmmc)
+        t.join();
+    for (auto& t : tmmp)
+        t.join();
+    return n == N*NT && mm.clear() == 0;
+}
+
+struct alignas(64) aligned_x {
+    int v;
+};
+
+bool test_slab_over_aligned() {
+    cout << "testing slab allocator over aligned..." << std::endl;
+    lockless::slab_allocator<aligned_x> a;
+    aligned_x* p[8];
+    for (auto& i : p) {
+        i = a.allocate(1);
+        TEST(uintptr_t(i) % alignof(aligned_x) == 0);
+    }
+    for (auto i : p)
+        a.deallocate(i, 1);
+    mpmc_fifo<aligned_x, lockless::null_stats, lockless::slab_allocator<aligned_x>> mm;
+    for (int i = 0; i < N; ++i)
+        mm.push(aligned_x{i});
+    aligned_x x;
+    for (int i = 0; i < N; ++i) {
+        TEST(mm.pop(&x) && x.v == i);
+    }
+    return !mm.pop();
+}
+
+static_assert(std::is_same<lockless::spsc_queue<X>::type, spsc_fifo<X, lockless::size_stats<>>>::value, "spsc counts size");
+static_assert(std::is_same<lockless::queue<X, 4, 1>::type, mpsc_fifo<X, lockless::size_stats<>>>::value, "mpsc counts size");
+static_assert(std::is_same<lockless::queue<X, lockless::one, lockless::many>::type, mpmc_fifo<X, lockless::size_stats<>>>::value, "spmc uses mpmc");
+static_assert(std::is_same<lockless::mpmc_queue<X, lockless::sharded_stats<>>::type, mpmc_fifo<X, lockless::sharded_stats<>>>::value, "counting Stats is used as is");
+static_assert(std::is_same<lockless::bounded_queue<X, lockless::one, lockless::one>::type, spsc_bounded_fifo<X>>::value, "bounded spsc");
+static_assert(std::is_same<lockless::bounded_queue<X, lockless::many, lockless::one>::type, mpmc_bounded_fifo<X>>::value, "bounded mpsc uses mpmc");
+
+template<class Q>
+bool queue_rw(Q& q, int producers) {
+    thread tp[NT];
+    for (int k = 0; k < producers; ++k) {
+        tp[k] = thread([&q, k]{
+            for (int i = 0; i < N/10;) {
+                if (k % 2 ? q.emplace(k, float(i)) : q.try_push(X{k, float(i)}))
+                    i++;
+                else
+                    this_thread::yield();
+            }
+        });
+    }
+    float last[NT];
+    for (auto& f : last)
+        f = -1;
+    for (int i = 0; i < producers*N/10;) {
+        X x;
+        if (!q.try_pop(&x)) {
+            this_thread::yield();
+            continue;
+        }
+        if (x.b <= last[x.a]) // in order for each producer
+            return false;
+        last[x.a] = x.b;
+        i++;
+    }
+    for (int k = 0; k < producers; ++k)
+        tp[k].join();
+    return q.size_approx() == 0 && !q.try_pop();
+}
+
+bool test_queue() {
+    cout << "testing queue selected by producers and consumers..." << std::endl;
+    lockless::spsc_queue<X, lockless::sharded_stats<>> ss;
+    lockless::mpsc_queue<X, lockless::sharded_stats<>> ms;
+    lockless::mpmc_queue<X, lockless::sharded_stats<>> mm;
+    lockless::bounded_queue<X, lockless::one, lockless::one> bs(64);
+    lockless::bounded_queue<X> bm(64);
+    TEST(ss.try_push(X{0, 1.0f}) && ss.size_approx() == 1 && ss.clear() == 1);
+    for (int i = 0; i < 64; ++i)
+        TEST(bm.emplace(0, float(i)));
+    TEST(!bm.try_push(X{0, 1.0f}) && bm.size_approx() == 64 && bm.clear() == 64);
+    return queue_rw(ss, 1) && queue_rw(ms, NT) && queue_rw(mm, NT) && queue_rw(bs, 1) && queue_rw(bm, NT);
+}
+
+// the documented api(concurrent_queue) only
+template<class Q>
+bool queue_api(Q& q) {
+    typename Q::value_type v = 1;
+    typename Q::value_type x = 0;
+    TEST(q.size_approx() == 0);
+    TEST(q.try_push(v));
+    TEST(q.try_push(2));
+    TEST(q.emplace(3));
+    TEST(q.size_approx() == 3);
+    TEST(q.try_pop(&x) && x == 1);
+    TEST(q.try_pop(&x) && x == 2);
+    TEST(q.try_pop());
+    TEST(!q.try_pop(&x));
+    return q.size_approx() == 0;
+}
+
+bool test_queue_default() {
+    cout << "testing default queue..." << std::endl;
+    lockless::queue<int> q;
+    lockless::bounded_queue<int> b(4);
+    TEST(queue_api(q) && queue_api(b));
+    return q.try_push(4) && q.clear() == 1 && q.size_approx() == 0;
+}
+
+// every value is popped exactly once. with 1 consumer, values of a producer are in order
+bool test_sharded_rw(int consumers) {
+    cout << "testing sharded fifo rw with " << consumers << " consumers..." << std::endl;
+    lockless::sharded_fifo<X> q(4);
+    TEST(q.shards() == 4);
+    thread tp[NT];
+    for (int k = 0; k < NT; ++k) {
+        tp[k] = thread([&q, k]{
+            for (int i = 0; i < N/10; ++i)
+                q.emplace(k, float(i));
+        });
+    }
+    atomic<int> popped{0};
+    atomic<bool> ordered{true};
+    vector<atomic<long long>> sums(NT);
+    vector<thread> tc;
+    for (int c = 0; c < consumers; ++c) {
+        tc.emplace_back([&]{
+            float last[NT];
+            for (auto& f : last)
+                f = -1;
+            while (popped.load(memory_order_relaxed) < NT*N/10) {
+                X x;
+                if (!q.pop(&x)) {
+                    this_thread::yield();
+                    continue;
+                }
+                if (consumers == 1 && x.b <= last[x.a])
+                    ordered = false;
+                last[x.a] = x.b;
+                sums[x.a] += (long long)x.b;
+                popped++;
+            }
+        });
+    }
+    for (auto& t : tp)
+        t.join();
+    for (auto& t : tc)
+        t.join();
+    for (auto& s : sums) {
+        if (s != (long long)(N/10)*(N/10 - 1)/2)
+            return false;
+    }
+    return ordered && !q.pop();
+}
+
+bool test_spsc_record_commit() {
+    cout << "testing spsc record ring commit without reserve and release without peek..." << std::endl;
+    bool thrown = false;
+    try {
+        lockless::spsc_record_ring z(0);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    TEST(thrown);
+    lockless::spsc_record_ring r(64);
+    r.commit(8); // nothing reserved
+    TEST(r.empty());
+    auto s = r.reserve(8);
+    TEST(s);
+    memset(s.data, 1, 8);
+    r.commit();
+    TEST(!r.reserve(64)); // too large
+    r.commit(8); // must not rewrite the header of the last record
+    r.commit();
+    r.release(); // nothing peeked
+    auto p = r.peek();
+    TEST(p && p.size == 8 && p.data[7] == 1);
+    r.release();
+    r.release(); // already released
+    TEST(r.empty() && !r.peek());
+    r.release(); // peek() returned empty
+    s = r.reserve(16);
+    TEST(s);
+    r.commit();
+    p = r.peek();
+    TEST(p && p.size == 16);
+    r.release();
+    r.release();
+    return r.empty() && !r.peek();
+}
+
+// records of 16 bytes to 64KB
+static size_t record_size(int i) { return i % 16 == 0 ? 64*1024 - i % 7 : 16 + (i*37) % 2000; }
+
+bool test_spsc_record_rw() {
+    cout << "testing spsc record ring rw..." << std::endl;
+    lockless::spsc_record_ring r(256*1024);
+    auto s = r.reserve(r.max_record_size() + 1);
+    TEST(!s && r.reserve(r.max_record_size()));
+    thread tp([&r]{
+        for (int i = 0; i < N/10;) {
+            const size_t n = record_size(i);
+            auto s = r.reserve(n + 100);
+            if (!s) {
+                this_thread::yield();
+                continue;
+            }
+            memset(s.data, i & 0xff, n);
+            memcpy(s.data, &i, sizeof(i));
+            r.commit(n);
+            i++;
+        }
+    });
+    for (int i = 0; i < N/10;) {
+        auto s = r.peek();
+        if (!s) {
+            this_thread::yield();
+            continue;
+        }
+        int v = -1;
+        memcpy(&v, s.data, sizeof(v));
+        if (v != i || s.size != record_size(i) || s.data[s.size - 1] != uint8_t(i & 0xff))
+            return false;
+        r.release();
+        i++;
+    }
+    tp.join();
+    return r.empty() && !r.peek();
+}
+
+bool test_spsc_record_vs_vector() {
+    cout << "testing spsc record ring vs spsc_fifo<vector<char>>..." << std::endl;
+    auto t0 = steady_clock::now();
+    lockless::spsc_record_ring r(1024*1024);
+    thread tp([&r]{
+        for (int i = 0; i < N; ++i) {
+            const size_t n = 16 + i % 1024;
+            lockless::record_span<uint8_t> s;
+            while (!(s = r.reserve(n)))
+                this_thread::yield();
+            memset(s.data, i, n);
+            r.commit();
+        }
+    });
+    for (int i = 0; i < N;) {
+        if (!r.peek()) {
+            this_thread::yield();
+            continue;
+        }
+        r.release();
+        i++;
+    }
+    tp.join();
+    const auto tr = duration_cast<milliseconds>(steady_clock::now() - t0).count();
+    t0 = steady_clock::now();
+    spsc_fifo<vector<char>> q;
+    thread tq([&q]{
+        for (int i = 0; i < N; ++i)
+            q.push(vector<char>(16 + i % 1024, char(i)));
+    });
+    for (int i = 0; i < N;) {
+        vector<char> v;
+        if (!q.pop(&v)) {
+            this_thread::yield();
+            continue;
+        }
+        i++;
+    }
+    tq.join();
+    const auto tq_ms = duration_cast<milliseconds>(steady_clock::now() - t0).count();
+    cout << "record ring: " << tr << "ms, spsc_fifo<vector<char>>: " << tq_ms << "ms" << std::endl;
+    return true;
+}
+
+// producers are child processes attached by name
+bool test_shm_spsc_fork() {
+    cout << "testing shm spsc fifo between processes..." << std::endl;
+    const string name = "/lockless_test_spsc." + to_string(getpid());
+    lockless::shm_spsc_fifo<X> q(name.data(), 1024);
+    const pid_t pid = fork();
+    if (pid == 0) {
+        lockless::shm_spsc_fifo<X> p(name.data());
+        for (int i = 0; i < N;) {
+            if (p.emplace(i, float(i)))
+                i++;
+            else
+                this_thread::yield();
+        }
+        _exit(0);
+    }
+    for (int i = 0; i < N;) {
+        X x;
+        if (!q.pop(&x)) {
+            this_thread::yield();
+            continue;
+        }
+        if (x.a != i || x.b != float(i))
+            return false;
+        i++;
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 && q.empty();
+}
+
+bool test_shm_mpsc_fork() {
+    cout << "testing shm mpsc fifo between processes..." << std::endl;
+    const string name = "/lockless_test_mpsc." + to_string(getpid());
+    lockless::shm_mpsc_fifo<X> q(name.data(), 256);
+    try {
+        lockless::shm_spsc_fifo<X> bad(name.data());
+        return false;
+    } catch (const std::system_error&) {} // layout mismatch
+    pid_t pids[NT];
+    for (int k = 0; k < NT; ++k) {
+        pids[k] = fork();
+        if (pids[k] == 0) {
+            lockless::shm_mpsc_fifo<X> p(name.data());
+            for (int i = 0; i < N/10;) {
+                if (p.emplace(k, float(i)))
+                    i++;
+                else
+                    this_thread::yield();
+            }
+            _exit(0);
+        }
+    }
+    float last[NT];
+    for (auto& f : last)
+        f = -1;
+    for (int i = 0; i < NT*N/10;) {
+        X x;
+        if (!q.pop(&x)) {
+            this_thread::yield();
+            continue;
+        }
+        if (x.a < 0 || x.a >= NT || x.b <= last[x.a]) // in order for each producer
+            return false;
+        last[x.a] = x.b;
+        i++;
+    }
+    for (auto pid : pids) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            return false;
+    }
+    return q.empty();
+}
+
 int main()
 {
     X *x = new X{1,2.0f};
@@ -167,17 +905,74 @@ int main()
     TEST(test_spsc_rw());
     std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
     t0 = steady_clock::now();
+    TEST(test_spsc_bounded_push_count());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_spsc_bounded_rw());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
     TEST(test_mpsc_push_count());
     std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
     t0 = steady_clock::now();
     TEST(test_mpsc_rw());
     std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
     t0 = steady_clock::now();
+    TEST(test_mpsc_rw_batch());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
     TEST(test_mpmc_push_count());
     std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
     t0 = steady_clock::now();
     TEST(test_mpmc_rw());
     std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
     t0 = steady_clock::now();
+    TEST(test_mpmc_rw_batch());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_mpmc_stats());
+    TEST(test_hazard_guard_nested());
+    TEST(test_mpmc_reclaim_backlog());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_mpmc_wait_pop<lockless::spin_wait>());
+    TEST(test_mpmc_wait_pop<lockless::eventcount>());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_mpmc_bounded_push_count());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_mpmc_bounded_rw());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_mpsc_allocator());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_mpmc_slab_rw());
+    TEST(test_push_range_throw());
+    TEST(test_slab_over_aligned());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_sharded_rw(1));
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_sharded_rw(NT));
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_queue());
+    TEST(test_queue_default());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_spsc_record_commit());
+    TEST(test_spsc_record_rw());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_spsc_record_vs_vector());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_shm_spsc_fork());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_shm_mpsc_fork());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
     return 0;
 }
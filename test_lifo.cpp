@@ -6,6 +6,9 @@
 
 #include "mpsc_lifo.h"
 #include "mpmc_lifo.h"
+#include "mpmc_tagged_lifo.h"
+#include "pool.h"
+#include "slab_allocator.h"
 #include <cstdlib>
 #include <thread>
 #include <iostream>
@@ -73,6 +76,31 @@ bool test_mpsc_rw() {
     return true;
 }
 
+bool test_mpsc_pop_all() {
+    cout << "testing mpsc pop all..." << std::endl;
+    mpsc_lifo<X> ms;
+    thread tmsp[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmsp[k] = thread([&ms]{
+            for (int i = 0; i < N; ++i)
+                ms.emplace(i, float(i));
+        });
+    }
+    int n = 0;
+    thread tmsc([&ms, &n]{
+        while (n < N*NT) {
+            auto c = ms.pop_all();
+            c.reverse();
+            for (const auto& x : c)
+                n += x.a >= 0;
+        }
+    });
+    tmsc.join();
+    for (auto& t : tmsp)
+        t.join();
+    return n == N*NT && ms.size() == 0 && ms.clear() == 0;
+}
+
 bool test_mpmc_push_count() {
     cout << "testing mpmc push count..." << std::endl;
     mpmc_lifo<X> mm;
@@ -118,6 +146,193 @@ bool test_mpmc_rw() {
     return true;
 }
 
+bool test_mpmc_pop_all() {
+    cout << "testing mpmc pop all..." << std::endl;
+    mpmc_lifo<X> mm;
+    thread tmmp[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmmp[k] = thread([&mm]{
+            for (int i = 0; i < N; ++i)
+                mm.emplace(i, float(i));
+        });
+    }
+    std::atomic<int> n{0};
+    thread tmmc[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmmc[k] = thread([&mm, &n]{
+            while (n < N*NT) {
+                if (mm.pop()) {
+                    n++;
+                    continue;
+                }
+                auto c = mm.pop_all();
+                c.reverse(); // a pop() failed to CAS may still read next of the chain
+                n += c.size();
+            }
+        });
+    }
+    for (auto& t : tmmc)
+        t.join();
+    for (auto& t : tmmp)
+        t.join();
+    return n == N*NT && mm.clear() == 0;
+}
+
+bool test_mpmc_tagged_push_count() {
+    cout << "testing mpmc tagged push count..." << std::endl;
+    mpmc_tagged_lifo<X> mm;
+    thread tmmp[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmmp[k] = thread([&mm]{
+            for (int i = 0; i < N; ++i)
+                mm.emplace(i, float(i));
+        });
+    }
+    for (auto& t: tmmp)
+        t.join();
+    return mm.clear() == N*NT;
+}
+
+bool test_mpmc_tagged_rw() {
+    cout << "testing mpmc tagged rw..." << std::endl;
+    mpmc_tagged_lifo<X> mm;
+    thread tmmp[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmmp[k] = thread([&mm]{
+            for (int i = 0; i < N; ++i)
+                mm.emplace(i, float(i));
+        });
+    }
+    thread tmmc[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmmc[k] = thread([&mm]{
+            for (int i = 0; i < N; ++i) {
+                X x;
+                if (!mm.pop(&x)) {
+                    //std::cout << this_thread::get_id() << " mpmc tagged pop failed @" << i << std::endl;
+                }
+            }
+        });
+    }
+    for (auto& t : tmmc)
+        t.join();
+    for (auto& t : tmmp)
+        t.join();
+    printf("mpmc tagged pop fail count: %d\n", mm.clear());
+    return true;
+}
+
+bool test_mpsc_slab_pop_all() {
+    cout << "testing mpsc slab allocator pop all..." << std::endl;
+    mpsc_lifo<X, lockless::null_stats, lockless::slab_allocator<X>> ms;
+    thread tmsp[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmsp[k] = thread([&ms]{
+            for (int i = 0; i < N; ++i)
+                ms.emplace(i, float(i));
+        });
+    }
+    int n = 0;
+    while (n < N*NT) {
+        if (ms.pop()) {
+            n++;
+            continue;
+        }
+        const int c = ms.pop_all().size();
+        n += c;
+        if (!c)
+            this_thread::yield();
+    }
+    for (auto& t : tmsp)
+        t.join();
+    return n == N*NT && ms.clear() == 0;
+}
+
+bool test_mpmc_slab_rw() {
+    cout << "testing mpmc slab allocator rw..." << std::endl;
+    mpmc_lifo<X, lockless::null_stats, lockless::slab_allocator<X>> mm;
+    thread tmmp[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmmp[k] = thread([&mm]{
+            for (int i = 0; i < N; ++i)
+                mm.emplace(i, float(i));
+        });
+    }
+    std::atomic<int> n{0};
+    thread tmmc[NT];
+    for (int k = 0; k < NT; ++k) {
+        tmmc[k] = thread([&mm, &n]{
+            while (n < N*NT) {
+                if (mm.pop())
+                    n++;
+                else
+                    this_thread::yield();
+            }
+        });
+    }
+    for (auto& t : tmmc)
+        t.join();
+    for (auto& t : tmmp)
+        t.join();
+    return n == N*NT && mm.clear() == 0;
+}
+
+static_assert(sizeof(mpmc_pool<X>::handle) <= 3*sizeof(void*), "pool handle is small");
+
+bool test_mpmc_pool_magazine() {
+    cout << "testing mpmc pool magazine..." << std::endl;
+    std::atomic<int> created{0};
+    mpmc_pool<X> p;
+    {
+        auto h = p.get2([]{ return new X{1, 1}; }); // fixed pool
+        auto h2 = std::move(h);
+        if (h || !h2 || h2->a != 1)
+            return false;
+    }
+    if (p.get2([]{ return new X(); })->a != 1) // recycled
+        return false;
+    for (int round = 0; round < 2; ++round) { // threads of round 1 adopt magazines of exited threads
+        thread ts[NT];
+        for (auto& t : ts) {
+            t = thread([&p, &created]{
+                for (int i = 0; i < N; ++i) {
+                    auto a = p.get([&created]{ created++; return new X(); });
+                    auto b = p.get([&created]{ created++; return new X(); });
+                }
+            });
+        }
+        for (auto& t : ts)
+            t.join();
+    }
+    return created <= NT*(2 + 2*32) && p.misses() == uint64_t(created) && p.clear() == created + 1; // + 1 in fixed pool
+}
+
+bool test_mpmc_pool_fixed() {
+    cout << "testing mpmc pool fixed slots..." << std::endl;
+    mpmc_pool<X, 1000> p; // not multiple of 64
+    std::atomic<int> created{0};
+    std::atomic<bool> ok{true};
+    thread ts[NT];
+    for (int k = 0; k < NT; ++k) {
+        ts[k] = thread([&, k]{
+            for (int i = 0; i < N/100; ++i) {
+                mpmc_pool<X, 1000>::handle hs[100];
+                for (auto& h : hs) {
+                    h = p.get2([&created]{ created++; return new X(); });
+                    h->a = k; // a slot is used by only 1 thread
+                }
+                for (auto& h : hs) {
+                    if (h->a != k)
+                        ok = false;
+                }
+            }
+        });
+    }
+    for (auto& t : ts)
+        t.join();
+    return ok && created <= 1000 && p.misses() == 0 && p.clear() == created;
+}
+
 int main()
 {
     auto t0 = steady_clock::now();
@@ -127,11 +342,35 @@ int main()
     TEST(test_mpsc_rw());
     std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
     t0 = steady_clock::now();
+    TEST(test_mpsc_pop_all());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
     TEST(test_mpmc_push_count());
     std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
     t0 = steady_clock::now();
     TEST(test_mpmc_rw());
     std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
     t0 = steady_clock::now();
+    TEST(test_mpmc_pop_all());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_mpmc_tagged_push_count());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_mpmc_tagged_rw());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_mpsc_slab_pop_all());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_mpmc_slab_rw());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_mpmc_pool_magazine());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_mpmc_pool_fixed());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
     return 0;
 }
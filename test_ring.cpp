@@ -0,0 +1,435 @@
+/*
+ * Copyright (c) 2026 WangBin <wbsecg1 at gmail.com>
+ * MIT License
+ * https://github.com/wang-bin/lockless
+ */
+
+#include "mpsc_ring.h"
+#include "ring.h"
+#include "mirror_ring.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <iostream>
+#include <chrono>
+
+using namespace std;
+using namespace chrono;
+
+// count global allocations of this program
+static std::atomic<long> allocations{0};
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+#define TEST(expr) do { \
+        if (!(expr)) { \
+                std::cerr << __LINE__ << " test error: " << #expr << std::endl; \
+                exit(1); \
+        } \
+} while(false)
+
+struct X {
+    int a; // producer
+    int b; // sequence
+    int check; // a torn value has a wrong check
+};
+
+static X make_x(int a, int b) { return X{a, b, a*31 + b*7 + 1}; }
+
+static const int N = 500000;
+static const int NT = 6;
+
+bool test_mpsc_ring_overwrite() {
+    cout << "testing mpsc ring overwrite..." << std::endl;
+    lockless::mpsc::ring<X> r(16);
+    for (int i = 0; i < 16; ++i)
+        TEST(r.push(make_x(0, i)));
+    TEST(r.size() == 16);
+    for (int i = 16; i < 20; ++i)
+        TEST(!r.push(make_x(0, i))); // overwrite oldest
+    TEST(r.size() == 16);
+    X x;
+    for (int i = 4; i < 20; ++i) { // latest 16 values in order
+        TEST(r.pop(&x) > 0);
+        TEST(x.b == i);
+    }
+    return r.pop() == 0 && r.empty();
+}
+
+// values from a producer are in order, never torn or duplicated. some are lost because of overwrite
+bool test_mpsc_ring_rw() {
+    cout << "testing mpsc ring rw..." << std::endl;
+    lockless::mpsc::static_ring<X, 256> r;
+    atomic<int> producing{NT};
+    thread tp[NT];
+    for (int k = 0; k < NT; ++k) {
+        tp[k] = thread([&r, &producing, k]{
+            for (int i = 0; i < N; ++i)
+                r.push(make_x(k, i));
+            producing--;
+        });
+    }
+    int last[NT];
+    for (auto& i : last)
+        i = -1;
+    long long n = 0;
+    X x;
+    for (;;) {
+        if (!r.pop(&x)) {
+            if (producing == 0 && !r.pop(&x))
+                break;
+            this_thread::yield();
+            continue;
+        }
+        if (x.a < 0 || x.a >= NT || x.check != make_x(x.a, x.b).check || x.b <= last[x.a])
+            return false;
+        last[x.a] = x.b;
+        n++;
+    }
+    for (auto& t : tp)
+        t.join();
+    printf("mpsc ring popped %lld of %d\n", n, N*NT);
+    return n > 0 && r.pushed() == uint64_t(N*NT);
+}
+
+bool test_ring_bulk() {
+    cout << "testing ring bulk write/read..." << std::endl;
+    ring<int> r(10);
+    int in[25], out[25];
+    for (int i = 0; i < 25; ++i)
+        in[i] = i;
+    for (int k = 0; k < 20; ++k) { // wrap around at different positions
+        TEST(r.write(in, 7) == 7);
+        TEST(r.size() == 7);
+        TEST(r.peek(out, 3) == 3 && out[0] == 0 && out[2] == 2);
+        TEST(r.read(out, 25) == 7);
+        for (int i = 0; i < 7; ++i)
+            TEST(out[i] == i);
+        r.push(k);
+        TEST(r.pop(out) && out[0] == k);
+    }
+    r.write(in, 6);
+    TEST(r.write(in + 6, 6) == 6); // overwrite 2 oldest
+    TEST(r.read(out, 25) == 10 && out[0] == 2 && out[9] == 11);
+    TEST(r.write(in, 25) == 10); // last 10 values
+    TEST(r.read(out, 25) == 10 && out[0] == 15 && out[9] == 24);
+
+    static_ring<string, 4> s; // not trivially copyable
+    const string sv[] = {"a", "b", "c", "d", "e"};
+    string so[5];
+    s.write(sv, 3);
+    TEST(s.read(so, 2) == 2 && so[0] == "a" && so[1] == "b");
+    s.write(sv + 3, 2);
+    TEST(s.read(so, 5) == 3 && so[0] == "c" && so[2] == "e");
+    return r.empty() && s.empty();
+}
+
+// rings without overflow::block have no condition variable, and can be copied and moved
+static_assert(std::is_copy_constructible<ring<int>>::value && std::is_move_assignable<static_ring<int, 4>>::value, "ring is copyable");
+static_assert(sizeof(ring<float>) <= sizeof(std::vector<float>) + 4*sizeof(size_t) + sizeof(void*), "no wait state in non-blocking ring");
+
+bool test_ring_copy() {
+    cout << "testing ring copy and move..." << std::endl;
+    ring<int> r(4);
+    for (int i = 0; i < 6; ++i)
+        r.push(i);
+    ring<int> c(r);
+    TEST(c.size() == 4 && c.front() == 2 && c.overwrites() == 2);
+    ring<int> m(std::move(c));
+    TEST(m.size() == 4 && m.at(3) == 5);
+    static_ring<int, 4> s;
+    s.push(1);
+    static_ring<int, 4> s2;
+    s2 = s;
+    TEST(s2.size() == 1 && s2.front() == 1);
+    s2 = std::move(s);
+    int v = 0;
+    TEST(s2.pop(&v) && v == 1 && r.size() == 4);
+    return true;
+}
+
+bool test_ring_overflow() {
+    cout << "testing ring overflow policy..." << std::endl;
+    int in[8] = {0, 1, 2, 3, 4, 5, 6, 7}, out[8];
+    ring<int> o(4);
+    for (int i = 0; i < 6; ++i)
+        TEST(o.push(i));
+    TEST(o.overwrites() == 2 && o.rejects() == 0);
+    TEST(!o.try_push(6) && o.rejects() == 1);
+    TEST(o.write(in, 3) == 3 && o.overwrites() == 5);
+    TEST(o.read(out, 8) == 4 && out[0] == 5 && out[3] == 2);
+
+    ring<int, null_mutex, lockless::overflow::reject> r(4);
+    for (int i = 0; i < 6; ++i)
+        TEST(r.push(i) == (i < 4));
+    TEST(r.rejects() == 2 && r.overwrites() == 0);
+    r.pop();
+    TEST(r.write(in, 3) == 1 && r.rejects() == 4);
+    TEST(r.read(out, 8) == 4 && out[0] == 1 && out[3] == 0);
+
+    ring<int, std::mutex, lockless::overflow::block> b(4);
+    thread tp([&b, &in]{
+        for (int i = 0; i < N/10; ++i)
+            b.push(i);
+        b.write(in, 8);
+    });
+    int n = 0;
+    for (int i = 0; i < N/10;) {
+        int v = -1;
+        if (!b.pop(&v)) {
+            this_thread::yield();
+            continue;
+        }
+        if (v != i++)
+            return false;
+    }
+    while (n < 8) {
+        const size_t m = b.read(out + n, 8 - n);
+        n += int(m);
+        if (m == 0)
+            this_thread::yield();
+    }
+    tp.join();
+    return out[0] == 0 && out[7] == 7 && b.overwrites() == 0 && b.rejects() == 0;
+}
+
+// ring_span never allocates
+bool test_ring_span_no_alloc() {
+    cout << "testing ring_span allocation..." << std::endl;
+    int buf[17];
+    string sbuf[5];
+    const long a0 = allocations.load();
+    {
+        ring_span<int> r(buf);
+        ring_span<int, std::mutex, lockless::overflow::reject> m(buf, buf + 17);
+        int out[8] = {};
+        for (int i = 0; i < 40; ++i) {
+            r.push(i);
+            r.emplace(i);
+            m.try_push(i);
+            int v;
+            r.pop(&v);
+            m.pop(&v);
+        }
+        r.write(out, 8);
+        r.read(out, 8);
+        if (auto p = m.claim(1))
+            *p = 2;
+        if (auto p = m.front_claim())
+            out[0] = *p;
+        ring_span<string> s(sbuf);
+        s.push(sbuf[0]); // empty string, no allocation
+        s.pop();
+    }
+    return allocations.load() == a0;
+}
+
+bool test_ring_span() {
+    cout << "testing ring_span..." << std::endl;
+    struct packet {
+        int a;
+        int b;
+    };
+    struct {
+        int header;
+        packet buf[9];
+        int footer;
+    } mem = {-1, {}, -2};
+    ring_span<packet> r(mem.buf);
+    TEST(r.capacity() == 8 && r.data() == mem.buf);
+    for (int i = 0; i < 10; ++i) {
+        if (i % 2)
+            r.push(packet{i, i});
+        else
+            r.emplace(i, i);
+    }
+    TEST(r.size() == 8 && r.overwrites() == 2);
+    TEST(r.front().a == 2 && r.at(7).a == 9 && r[1].b == 3);
+    packet p;
+    TEST(r.pop(&p) == 8 && p.a == 2);
+    packet out[8];
+    TEST(r.peek(out, 8) == 7 && out[6].a == 9);
+    TEST(r.read(out, 2) == 2 && out[1].a == 4);
+    TEST(r.write(out, 2) == 2 && r.size() == 7 && r.at(6).a == 4);
+    r.clear();
+    TEST(r.empty());
+
+    string sbuf[3]; // constructed objects
+    ring_span<string, std::mutex, lockless::overflow::reject> s(sbuf, sbuf + 3);
+    TEST(s.push("a") && s.push("b") && !s.push("c") && s.rejects() == 1);
+    string v;
+    TEST(s.pop(&v) && v == "a");
+    return mem.header == -1 && mem.footer == -2;
+}
+
+bool test_ring_claim() {
+    cout << "testing ring claim/publish..." << std::endl;
+    struct frame {
+        int id;
+        char data[64*1024];
+    };
+    static ring<frame, std::mutex, lockless::overflow::reject> r(3);
+    for (int i = 0; i < 5; ++i) {
+        auto f = r.claim(); // published at the end of scope
+        TEST(!!f == (i < 3));
+        if (!f)
+            continue;
+        f->id = i;
+        f->data[sizeof(f->data) - 1] = char(i);
+    }
+    for (int i = 0; i < 3; ++i) {
+        auto f = r.front_claim(); // popped at the end of scope
+        TEST(f && f->id == i && f->data[sizeof(f->data) - 1] == char(i));
+    }
+    TEST(!r.front_claim() && r.rejects() == 2);
+    // an exception between claim and publish unlocks the ring, and nothing is published
+    try {
+        auto f = r.claim();
+        f->id = 3;
+        throw 3;
+    } catch (int) {
+    }
+    TEST(r.empty());
+    r.push(frame{4, {}});
+    try {
+        auto f = r.front_claim();
+        throw f->id;
+    } catch (int) {
+    }
+    auto f = r.front_claim(); // not popped by the exception
+    return f && f->id == 4;
+}
+
+// samples of audio frames through a locked ring
+bool test_ring_bulk_throughput() {
+    cout << "testing ring bulk vs single value push/pop..." << std::endl;
+    static const int frame = 256;
+    float in[frame] = {}, out[frame];
+    ring<float, std::mutex> r(4096);
+    auto t0 = steady_clock::now();
+    for (int k = 0; k < N/10; ++k) {
+        for (int i = 0; i < frame; ++i)
+            r.push(in[i]);
+        for (int i = 0; i < frame; ++i)
+            r.pop(&out[i]);
+    }
+    const auto ts = duration_cast<milliseconds>(steady_clock::now() - t0).count();
+    t0 = steady_clock::now();
+    for (int k = 0; k < N/10; ++k) {
+        r.write(in, frame);
+        r.read(out, frame);
+    }
+    const auto tb = duration_cast<milliseconds>(steady_clock::now() - t0).count();
+    cout << "single: " << ts << "ms, bulk: " << tb << "ms" << std::endl;
+    return r.empty();
+}
+
+// producer writes records of random size across the end of ring, consumer reads each record at 1 pointer
+bool test_mirror_ring() {
+    cout << "testing mirror ring..." << std::endl;
+    lockless::mirror_ring r(1);
+    const size_t cap = r.capacity();
+    TEST(cap >= 4096 && r.writable() == cap);
+    r.commit(cap - 4); // next write wraps around
+    r.consume(cap - 4);
+    uint8_t* w = r.write_ptr();
+    for (int i = 0; i < 8; ++i)
+        w[i] = uint8_t(i);
+    r.commit(8);
+    const uint8_t* rp = r.read_ptr();
+    TEST(r.readable() == 8 && rp[3] == 3 && rp[7] == 7);
+    r.consume(8);
+
+    static const size_t total = 64*1024*1024;
+    thread tp([&r]{
+        uint32_t seq = 0;
+        size_t n = 0;
+        while (n < total) {
+            const size_t len = 4 + (seq*7919 % 1021)*4; // u32 words
+            if (r.writable() < len) {
+                this_thread::yield();
+                continue;
+            }
+            uint32_t* p = reinterpret_cast<uint32_t*>(r.write_ptr());
+            p[0] = uint32_t(len);
+            for (size_t i = 1; i < len/4; ++i)
+                p[i] = seq;
+            r.commit(len);
+            seq++;
+            n += len;
+        }
+        uint32_t end = 0;
+        while (r.writable() < 4)
+            this_thread::yield();
+        memcpy(r.write_ptr(), &end, 4);
+        r.commit(4);
+    });
+    uint32_t seq = 0;
+    for (;;) {
+        if (r.readable() < 4) {
+            this_thread::yield();
+            continue;
+        }
+        const uint32_t* p = reinterpret_cast<const uint32_t*>(r.read_ptr());
+        const size_t len = p[0];
+        if (len == 0)
+            break;
+        while (r.readable() < len)
+            this_thread::yield();
+        for (size_t i = 1; i < len/4; ++i) {
+            if (p[i] != seq)
+                return false;
+        }
+        r.consume(len);
+        seq++;
+    }
+    r.consume(4);
+    tp.join();
+    return r.empty();
+}
+
+int main()
+{
+    auto t0 = steady_clock::now();
+    TEST(test_mpsc_ring_overwrite());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_mpsc_ring_rw());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_ring_bulk());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_ring_copy());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_ring_overflow());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_ring_claim());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_ring_span_no_alloc());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_ring_span());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_ring_bulk_throughput());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_mirror_ring());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    return 0;
+}
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2026 WangBin <wbsecg1 at gmail.com>
+ * MIT License
+ * https://github.com/wang-bin/lockless
+ */
+
+#include "ws_deque.h"
+#include "mpmc_fifo.h"
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <iostream>
+#include <chrono>
+#include <vector>
+
+using namespace std;
+using namespace chrono;
+
+#define TEST(expr) do { \
+        if (!(expr)) { \
+                std::cerr << __LINE__ << " test error: " << #expr << std::endl; \
+                exit(1); \
+        } \
+} while(false)
+
+struct X {
+    int a;
+    float b;
+};
+
+static const int N = 500000;
+static const int NT = 6;
+
+bool test_owner() {
+    cout << "testing ws_deque owner push pop..." << std::endl;
+    ws_deque<X> q(4);
+    for (int i = 0; i < N; ++i)
+        q.push(X{i, float(i)});
+    TEST(q.size() == N);
+    TEST(q.capacity() >= N);
+    X x;
+    for (int i = N - 1; i >= 0; --i) { // lifo for owner
+        if (!q.pop(&x) || x.a != i)
+            return false;
+    }
+    return !q.pop() && q.empty();
+}
+
+// owner pushes and pops while thieves steal. every element must be taken exactly once
+bool test_steal() {
+    cout << "testing ws_deque steal..." << std::endl;
+    ws_deque<X> q(4); // grows while thieves are reading
+    vector<atomic<char>> taken(N);
+    atomic<int> count{0};
+    atomic<bool> done{false};
+    auto take = [&](const X& x) {
+        if (x.a < 0 || x.a >= N || x.b != float(x.a) || taken[x.a].exchange(1))
+            return false;
+        count++;
+        return true;
+    };
+    atomic<bool> ok{true};
+    thread thieves[NT];
+    for (auto& t : thieves) {
+        t = thread([&]{
+            X x;
+            while (!done || !q.empty()) {
+                if (q.steal(&x)) {
+                    if (!take(x))
+                        ok = false;
+                } else {
+                    this_thread::yield();
+                }
+            }
+        });
+    }
+    X x;
+    for (int i = 0; i < N; ++i) {
+        q.push(X{i, float(i)});
+        if (i % 3 == 0 && q.pop(&x) && !take(x))
+            ok = false;
+    }
+    while (q.pop(&x)) {
+        if (!take(x))
+            ok = false;
+    }
+    done = true;
+    for (auto& t : thieves)
+        t.join();
+    return ok && count == N;
+}
+
+// owner pushes growing bursts and drains them, so retired arrays are freed by pop() while thieves steal
+bool test_steal_reclaim() {
+    cout << "testing ws_deque steal with array reclaim..." << std::endl;
+    ws_deque<X> q(2);
+    atomic<int> count{0};
+    atomic<bool> done{false};
+    atomic<bool> ok{true};
+    thread thieves[NT];
+    for (auto& t : thieves) {
+        t = thread([&]{
+            X x;
+            while (!done) {
+                if (q.steal(&x)) {
+                    if (x.b != float(x.a))
+                        ok = false;
+                    count++;
+                } else {
+                    this_thread::yield();
+                }
+            }
+        });
+    }
+    X x;
+    int n = 0;
+    for (int burst = 4; burst <= N/4; burst *= 2) {
+        for (int i = 0; i < burst; ++i)
+            q.push(X{i, float(i)});
+        n += burst;
+        while (q.pop(&x)) {
+            if (x.b != float(x.a))
+                ok = false;
+            count++;
+        }
+    }
+    done = true;
+    for (auto& t : thieves)
+        t.join();
+    return ok && count == n;
+}
+
+// 1 producer, NT consumers. ws_deque consumers steal, mpmc_fifo consumers pop
+template<class Q, class Pop>
+long long steal_throughput(Q& q, Pop pop) {
+    atomic<int> count{0};
+    thread thieves[NT];
+    for (auto& t : thieves) {
+        t = thread([&]{
+            X x;
+            while (count.load(memory_order_relaxed) < N) {
+                if (pop(q, &x))
+                    count.fetch_add(1, memory_order_relaxed);
+            }
+        });
+    }
+    const auto t0 = steady_clock::now();
+    for (int i = 0; i < N; ++i)
+        q.push(X{i, float(i)});
+    for (auto& t : thieves)
+        t.join();
+    return duration_cast<milliseconds>(steady_clock::now() - t0).count();
+}
+
+bool test_steal_throughput() {
+    cout << "testing ws_deque steal throughput vs mpmc_fifo pop..." << std::endl;
+    ws_deque<X> wq;
+    const auto tw = steal_throughput(wq, [](ws_deque<X>& q, X* x) { return q.steal(x); });
+    mpmc_fifo<X> mq;
+    const auto tm = steal_throughput(mq, [](mpmc_fifo<X>& q, X* x) { return q.pop(x); });
+    cout << "ws_deque: " << tw << "ms, mpmc_fifo: " << tm << "ms" << std::endl;
+    return wq.empty() && !mq.pop();
+}
+
+int main()
+{
+    auto t0 = steady_clock::now();
+    TEST(test_owner());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_steal());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_steal_reclaim());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    t0 = steady_clock::now();
+    TEST(test_steal_throughput());
+    std::cout << "ms elapsed: " << duration_cast<milliseconds>(steady_clock::now() - t0).count() << std::endl;
+    return 0;
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2026 WangBin <wbsecg1 at gmail.com>
+ * MIT License
+ * Lock Free Work Stealing Deque
+ * https://github.com/wang-bin/lockless
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "cacheline.h"
+
+// Chase-Lev deque. Correct and Efficient Work-Stealing for Weak Memory Models(Le, Pop, Cohen, Zappa Nardelli, 2013)
+// the owner thread push() and pop() at bottom without CAS unless only 1 element left, thieves steal() at top with 1 CAS.
+// a thief may read a slot while the owner is writing the slot of the next round, so T must be trivially copyable and a slot is copied by words.
+// full array is replaced by a larger one. a thief may still read the old array, so old arrays are retired, and freed by the owner when pop() finds
+// the deque empty and no steal is in flight(thieves_ == 0). until then retired arrays are less than current array in total. the deque never shrinks
+template<typename T>
+class ws_deque {
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+public:
+    ws_deque(size_t cap = 64) {
+        size_t n = 2;
+        while (n < cap)
+            n <<= 1;
+        arrays_.emplace_back(new array(n));
+        array_.store(arrays_.back().get(), std::memory_order_relaxed);
+    }
+
+    // owner thread only
+    void push(const T& v) {
+        const int64_t b = bottom_.load(std::memory_order_relaxed);
+        const int64_t t = top_.load(std::memory_order_acquire);
+        array* a = array_.load(std::memory_order_relaxed);
+        if (b - t > int64_t(a->capacity()) - 1)
+            a = grow(a, t, b);
+        a->put(b, v);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // owner thread only. return false if empty
+    bool pop(T* v = nullptr) {
+        const int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        array* a = array_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        if (t > b) { // empty
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            if (arrays_.size() > 1)
+                reclaim();
+            return false;
+        }
+        if (v)
+            a->get(b, v);
+        if (t == b) { // last element, race with thieves
+            const bool ok = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return ok;
+        }
+        return true;
+    }
+
+    // any thread. return false if empty or lost the race with owner or another thief
+    bool steal(T* v = nullptr) {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b)
+            return false;
+        thieves_.fetch_add(1, std::memory_order_seq_cst); // pair with reclaim(): either owner sees a thief in flight, or thief sees the new array
+        array* a = array_.load(std::memory_order_seq_cst);
+        typename array::words w;
+        a->load(t, w);
+        thieves_.fetch_sub(1, std::memory_order_release);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return false;
+        if (v)
+            memcpy(v, w.data, sizeof(T));
+        return true;
+    }
+
+    // approximate if called by thieves
+    size_t size() const {
+        const int64_t b = bottom_.load(std::memory_order_relaxed);
+        const int64_t t = top_.load(std::memory_order_relaxed);
+        return b > t ? size_t(b - t) : 0;
+    }
+    bool empty() const { return size() == 0;}
+    size_t capacity() const { return array_.load(std::memory_order_relaxed)->capacity(); }
+private:
+    class array {
+    public:
+        static constexpr size_t word_count = (sizeof(T) + sizeof(uintptr_t) - 1)/sizeof(uintptr_t);
+        struct words {
+            uintptr_t data[word_count];
+        };
+
+        array(size_t cap) : cap_(cap), slots_(new std::atomic<uintptr_t>[cap*word_count]) {}
+        size_t capacity() const { return cap_; }
+        size_t index(int64_t i) const { return size_t(i) & (cap_ - 1);} // cap_ is power of 2
+
+        void load(int64_t i, words& w) const {
+            const std::atomic<uintptr_t>* s = &slots_[index(i)*word_count];
+            for (size_t k = 0; k < word_count; ++k)
+                w.data[k] = s[k].load(std::memory_order_relaxed);
+        }
+        void get(int64_t i, T* v) const {
+            words w;
+            load(i, w);
+            memcpy(v, w.data, sizeof(T));
+        }
+        void put(int64_t i, const T& v) {
+            words w{};
+            memcpy(w.data, &v, sizeof(T));
+            store(i, w);
+        }
+        void store(int64_t i, const words& w) {
+            std::atomic<uintptr_t>* s = &slots_[index(i)*word_count];
+            for (size_t k = 0; k < word_count; ++k)
+                s[k].store(w.data[k], std::memory_order_relaxed);
+        }
+    private:
+        size_t cap_;
+        std::unique_ptr<std::atomic<uintptr_t>[]> slots_;
+    };
+
+    array* grow(array* a, int64_t t, int64_t b) {
+        array* n = new array(a->capacity()*2);
+        typename array::words w;
+        for (int64_t i = t; i < b; ++i) {
+            a->load(i, w);
+            n->store(i, w);
+        }
+        arrays_.emplace_back(n);
+        array_.store(n, std::memory_order_seq_cst);
+        return n;
+    }
+
+    // free retired arrays if no thief may read them. a thief starting after the check loads the current array
+    void reclaim() {
+        if (thieves_.load(std::memory_order_seq_cst) != 0)
+            return;
+        arrays_.erase(arrays_.begin(), arrays_.end() - 1);
+    }
+
+    alignas(lockless::cacheline_size) std::atomic<int64_t> top_ = {0}; // thieves
+    std::atomic<int> thieves_ = {0}; // steals reading array_
+    alignas(lockless::cacheline_size) std::atomic<int64_t> bottom_ = {0}; // owner
+    std::atomic<array*> array_ = {nullptr};
+    std::vector<std::unique_ptr<array>> arrays_; // owner. current and retired arrays
+};